@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+
+r"""
+    Converts MangoHud binary logs (log_format=binary) to the csv log format.
+"""
+from pathlib import Path
+import argparse
+import io
+import struct
+import subprocess
+import sys
+
+FILE_MAGIC = b"MHLOGBIN"
+BLOCK_MAGIC = b"BLK1"
+SUPPORTED_VERSION = 1
+COLUMN_NAME_SIZE = 31
+
+# log_compression= writes concatenated frames that the command line tools can decode
+DECOMPRESSORS = {
+    b"\x28\xb5\x2f\xfd": ["zstd", "-dcq"],
+    b"\x04\x22\x4d\x18": ["lz4", "-dcq"],
+}
+
+# log_column_type in src/log_schema.h
+COLUMN_TYPES = {
+    0: "d",  # LOG_COLUMN_F64
+    1: "f",  # LOG_COLUMN_F32
+    2: "i",  # LOG_COLUMN_I32
+    3: "q",  # LOG_COLUMN_I64
+}
+
+
+def format_value(value) -> str:
+    r"""
+        formats a value the same way std::ostream does with default flags
+    """
+    if isinstance(value, float):
+        return "%g" % value
+    return str(value)
+
+
+def read_header(f):
+    magic = f.read(len(FILE_MAGIC))
+    if magic != FILE_MAGIC:
+        raise ValueError("not a MangoHud binary log")
+
+    version, column_count, preamble_size, _ = struct.unpack("<4I", f.read(16))
+    if version != SUPPORTED_VERSION:
+        raise ValueError(f"unsupported binary log version {version}")
+
+    columns = []
+    for _ in range(column_count):
+        raw_name, col_type = struct.unpack(f"<{COLUMN_NAME_SIZE}sB", f.read(COLUMN_NAME_SIZE + 1))
+        if col_type not in COLUMN_TYPES:
+            raise ValueError(f"unknown column type {col_type}")
+        columns.append((raw_name.split(b"\0", 1)[0].decode(), COLUMN_TYPES[col_type]))
+
+    preamble = f.read(preamble_size).decode()
+    return columns, preamble
+
+
+def read_blocks(f, columns):
+    r"""
+        yields one list of column values per block, a truncated trailing block is dropped
+    """
+    while True:
+        block_header = f.read(8)
+        if len(block_header) < 8:
+            return
+        if block_header[:4] != BLOCK_MAGIC:
+            raise ValueError("corrupt block header")
+
+        rows = struct.unpack("<I", block_header[4:])[0]
+        values = []
+        for _, fmt in columns:
+            size = struct.calcsize(fmt) * rows
+            data = f.read(size)
+            if len(data) < size:
+                print("warning: dropping truncated block", file=sys.stderr)
+                return
+            values.append(struct.unpack(f"<{rows}{fmt}", data))
+        yield values
+
+
+def open_log(src: Path):
+    with open(src, "rb") as f:
+        magic = f.read(4)
+    for compressed_magic, command in DECOMPRESSORS.items():
+        if magic == compressed_magic:
+            # a log cut short by a crash ends in a partial frame, keep what decodes
+            result = subprocess.run(command + [str(src)], stdout=subprocess.PIPE, check=False)
+            return io.BytesIO(result.stdout)
+    return open(src, "rb")
+
+
+def convert(src: Path, dst: Path):
+    with open_log(src) as f, open(dst, "w") as out:
+        columns, preamble = read_header(f)
+        out.write(preamble)
+        out.write(",".join(name for name, _ in columns) + "\n")
+        for values in read_blocks(f, columns):
+            for row in zip(*values):
+                out.write(",".join(format_value(v) for v in row) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("input", nargs="+", type=Path, help="binary log files (.mhlog)")
+    parser.add_argument("-o", "--output", type=Path,
+                        help="output file, only valid with a single input. Defaults to <input>.csv")
+    args = parser.parse_args()
+
+    if args.output and len(args.input) > 1:
+        parser.error("--output can only be used with a single input file")
+
+    for src in args.input:
+        base = src.with_suffix("") if src.suffix in (".zst", ".lz4") else src
+        dst = args.output or base.with_suffix(".csv")
+        convert(src, dst)
+        print(f"{src} -> {dst}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,7 +1,9 @@
+#include <charconv>
 #include <filesystem>
 #include <vector>
-#include <fstream>
 #include <set>
+#include <fcntl.h>
+#include <unistd.h>
 #include <spdlog/spdlog.h>
 #include "fdinfo.hpp"
 
@@ -15,12 +17,11 @@ FDInfoBase::FDInfoBase(const std::string& drm_node, const pid_t pid) : drm_node(
 
 void FDInfoBase::init()
 {
-    std::vector<std::string> fds = find_fds();
+    std::vector<std::string> fd_names = find_fds();
 
-    fds_streams.clear();
-    fds_data.clear();
+    fds.clear();
 
-    open_fds(fds);
+    open_fds(fd_names);
 
     last_init = std::chrono::steady_clock::now();
 }
@@ -34,17 +35,106 @@ void FDInfoBase::poll() {
     if (diff >= 10s)
         init();
 
-    for (size_t i = 0; i < fds_streams.size(); i++) {
-        fds_streams[i].clear();
-        fds_streams[i].seekg(0);
+    for (fdinfo_fd& fd : fds)
+        read_fd(fd);
+}
+
+// Parses "<number>[ unit]", sizes are converted to bytes
+static uint64_t parse_fdinfo_value(std::string_view val) {
+    while (!val.empty() && (val.front() == ' ' || val.front() == '\t'))
+        val.remove_prefix(1);
+
+    uint64_t out = 0;
+    auto [ptr, ec] = std::from_chars(val.data(), val.data() + val.size(), out);
+
+    if (ec != std::errc())
+        return 0;
+
+    val.remove_prefix(ptr - val.data());
+
+    if (val == " KiB")
+        out <<= 10;
+    else if (val == " MiB")
+        out <<= 20;
+    else if (val == " GiB")
+        out <<= 30;
+
+    return out;
+}
+
+size_t FDInfoBase::resolve_slot(std::string_view key) {
+    // pos, flags, mnt_id and friends aren't interesting
+    if (key.substr(0, 4) != "drm-")
+        return npos;
+
+    return slots.try_emplace(std::string(key), slots.size()).first->second;
+}
+
+size_t FDInfoBase::slot(const std::string& key) const {
+    auto it = slots.find(key);
+    return it == slots.end() ? npos : it->second;
+}
+
+bool FDInfoBase::read_fd(fdinfo_fd& fd) {
+    if (buffer.size() < 4096)
+        buffer.resize(4096);
 
-        for (std::string line; std::getline(fds_streams[i], line);) {
-            auto key = line.substr(0, line.find(":"));
-            auto val = line.substr(key.length() + 2);
-            // SPDLOG_TRACE("{} = {}", key, val);
-            fds_data[i][key] = val;
+    // fdinfo is regenerated on every read from offset 0, one pread
+    // normally gets all of it, only grow when it didn't fit
+    ssize_t len;
+    while ((len = pread(fd.fd, buffer.data(), buffer.size(), 0)) == static_cast<ssize_t>(buffer.size()))
+        buffer.resize(buffer.size() * 2);
+
+    if (len < 0) {
+        SPDLOG_TRACE("failed to read fdinfo: {}", strerror(errno));
+        return false;
+    }
+
+    fd.present.assign(fd.present.size(), false);
+
+    std::string_view text(buffer.data(), len);
+    size_t line = 0;
+
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view l = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        size_t colon = l.find(':');
+
+        if (colon == std::string_view::npos)
+            continue;
+
+        std::string_view key = l.substr(0, colon);
+        size_t s;
+
+        if (line < fd.layout.size() && fd.layout[line].first == key) {
+            s = fd.layout[line].second;
+        } else {
+            s = resolve_slot(key);
+
+            if (line < fd.layout.size())
+                fd.layout[line] = { std::string(key), s };
+            else
+                fd.layout.emplace_back(std::string(key), s);
         }
+
+        line++;
+
+        if (s == npos)
+            continue;
+
+        if (s >= fd.values.size()) {
+            fd.values.resize(slots.size());
+            fd.present.resize(slots.size());
+        }
+
+        fd.values[s] = parse_fdinfo_value(l.substr(colon + 1));
+        fd.present[s] = true;
     }
+
+    fd.layout.resize(line);
+    return true;
 }
 
 std::vector<std::string> FDInfoBase::find_fds() {
@@ -85,41 +175,40 @@ std::vector<std::string> FDInfoBase::find_fds() {
     return fds;
 }
 
-void FDInfoBase::open_fds(const std::vector<std::string>& fds) {
+void FDInfoBase::open_fds(const std::vector<std::string>& fd_names) {
     // set of unique ids, dont open fds which contain
     // existing ids, because they will contain same data 
-    std::set<std::string> client_ids;
+    std::set<uint64_t> client_ids;
     size_t total = 0;
 
-    for (const std::string& fd: fds) {
+    for (const std::string& fd: fd_names) {
         fs::path p = "/proc/" + std::to_string(pid) + "/fdinfo/" + fd;
 
-        if (!fs::exists(p))
-            continue;
-
-        std::ifstream file(p);
+        fdinfo_fd file;
+        file.fd = unique_fd::adopt(open(p.c_str(), O_RDONLY | O_CLOEXEC));
 
-        if (!file.is_open()) {
+        if (!file.fd) {
             SPDLOG_TRACE("failed to open \"{}\"", p.string());
             continue;
         }
 
-        for (std::string line; std::getline(file, line);) {
-            std::string key = line.substr(0, line.find(":"));
-            std::string val = line.substr(key.length() + 2);
+        // this also resolves the keys of the fd for later polls
+        if (!read_fd(file))
+            continue;
+
+        size_t client_id = slot("drm-client-id");
 
-            if (key != "drm-client-id" || client_ids.find(val) != client_ids.end())
-                continue;
+        if (!file.has(client_id) || client_ids.count(file.get(client_id)))
+            continue;
 
-            total += 1;
-            client_ids.insert(val);
+        total += 1;
+        file.client_id = file.get(client_id);
+        client_ids.insert(file.client_id);
 
-            fds_streams.push_back(std::move(file));
-            fds_data.push_back({});
-        }
+        fds.push_back(std::move(file));
     }
 
-    SPDLOG_DEBUG("Received {} ids, opened {} unique ids", fds.size(), total);
+    SPDLOG_DEBUG("Received {} ids, opened {} unique ids", fd_names.size(), total);
 }
 
 std::string FDInfoBase::get_card_node() {
@@ -177,54 +266,37 @@ void FDInfoWrapper::poll_all() {
 }
 
 float FDInfoWrapper::get_memory_used(pid_t pid, const std::string& key) {
-    float total = 0;
-
     if (pids.find(pid) == pids.end())
         return 0.f;
 
     FDInfoBase& p = pids.at(pid);
+    size_t slot = p.slot(key);
 
-    for (const auto& fd : p.fds_data) {
-        if (fd.find(key) == fd.end())
-            continue;
-
-        std::string used = fd.at(key);
-
-        if (used.empty())
-            continue;
+    if (slot == FDInfoBase::npos)
+        return 0.f;
 
-        float val = static_cast<float>(std::stoull(used));
+    uint64_t total = 0;
 
-        if (used.find("KiB") != std::string::npos)
-            val /= 1024.f * 1024.f;
-        else if (used.find("MiB") != std::string::npos)
-            val /= 1024.f;
+    for (const auto& fd : p.fds)
+        total += fd.get(slot);
 
-        total += val;
-    }
-
-    return total;
+    return total / (1024.f * 1024.f * 1024.f);
 }
 
 uint64_t FDInfoWrapper::get_gpu_time(pid_t pid, const std::string& key) {
-    uint64_t total = 0;
-
     if (pids.find(pid) == pids.end())
         return 0;
 
     FDInfoBase& p = pids.at(pid);
+    size_t slot = p.slot(key);
 
-    for (const auto& fd : p.fds_data) {
-        if (fd.find(key) == fd.end())
-            continue;
-
-        std::string time = fd.at(key);
+    if (slot == FDInfoBase::npos)
+        return 0;
 
-        if (time.empty())
-            continue;
+    uint64_t total = 0;
 
-        total += std::stoull(time);
-    }
+    for (const auto& fd : p.fds)
+        total += fd.get(slot);
 
     return total;
 }
@@ -1,33 +1,64 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <chrono>
 
-typedef std::map<std::string, std::string> fdinfo_data;
+#include <spdlog/spdlog.h>
+
+#include "../common/helpers.hpp"
+
 typedef std::chrono::time_point<std::chrono::steady_clock> chrono_timer;
 
+// One open /proc/<pid>/fdinfo/<fd>. Values are indexed by the slots of the
+// owning FDInfoBase, memory sizes are stored in bytes.
+struct fdinfo_fd {
+    unique_fd fd;
+    uint64_t client_id = 0;
+
+    // key and slot of each line as last seen, lines keep their order
+    // between polls so this is checked instead of looking the key up again
+    std::vector<std::pair<std::string, size_t>> layout;
+    std::vector<uint64_t> values;
+    std::vector<bool> present;
+
+    bool has(size_t slot) const { return slot < present.size() && present[slot]; }
+    uint64_t get(size_t slot) const { return has(slot) ? values[slot] : 0; }
+};
+
 class FDInfoBase {
 private:
-    std::vector<std::ifstream> fds_streams;
     chrono_timer last_init;
     std::string card_node;
+    std::unordered_map<std::string, size_t> slots;
+    std::string buffer;
 
     std::vector<std::string> find_fds();
-    void open_fds(const std::vector<std::string>& fds);
+    void open_fds(const std::vector<std::string>& fd_names);
     std::string get_card_node();
+    bool read_fd(fdinfo_fd& fd);
+    size_t resolve_slot(std::string_view key);
 
 public:
+    static constexpr size_t npos = SIZE_MAX;
+
     const std::string drm_node;
     const pid_t pid;
 
     FDInfoBase(const std::string& drm_node, const pid_t pid);
-    std::vector<fdinfo_data> fds_data;
+    std::vector<fdinfo_fd> fds;
 
     void init();
     void poll();
+    // Slot of a drm-* key, npos if no fd has reported it yet
+    size_t slot(const std::string& key) const;
 };
 
 struct FDInfoWrapper {
@@ -110,19 +110,16 @@ int Intel_xe::get_process_load(pid_t pid) {
 
     double load = 0;
 
-    for (fdinfo_data& fd : p.fds_data) {
-        std::string client_id = fd["drm-client-id"];
-        std::string cur_cycles_str = fd["drm-cycles-rcs"];
-        std::string cur_total_cycles_str = fd["drm-total-cycles-rcs"];
-
-        if (
-            client_id.empty() || cur_cycles_str.empty() ||
-            cur_total_cycles_str.empty()
-        )
+    size_t cycles_slot = p.slot("drm-cycles-rcs");
+    size_t total_cycles_slot = p.slot("drm-total-cycles-rcs");
+
+    for (const fdinfo_fd& fd : p.fds) {
+        if (!fd.has(cycles_slot) || !fd.has(total_cycles_slot))
             continue;
 
-        uint64_t cur_cycles = std::stoull(cur_cycles_str);
-        uint64_t cur_total_cycles = std::stoull(cur_total_cycles_str);
+        uint64_t client_id = fd.client_id;
+        uint64_t cur_cycles = fd.get(cycles_slot);
+        uint64_t cur_total_cycles = fd.get(total_cycles_slot);
 
         if (previous_cycles.find(client_id) == previous_cycles.end()) {
             previous_cycles[client_id] = { cur_cycles, cur_total_cycles };
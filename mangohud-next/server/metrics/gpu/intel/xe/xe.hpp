@@ -27,7 +27,7 @@ private:
     };
 
     uint64_t previous_power_usage = 0;
-    std::map<std::string, std::pair<uint64_t, uint64_t>> previous_cycles;
+    std::map<uint64_t, std::pair<uint64_t, uint64_t>> previous_cycles;
 
     void find_gt_dir();
     void load_throttle_reasons(
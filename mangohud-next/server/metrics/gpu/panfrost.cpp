@@ -24,17 +24,16 @@ int Panfrost::get_core_clock() {
 
     // frequency is the same across all pids, so just take first pid
     FDInfoBase& data = fdinfo.pids.begin()->second;
-    std::vector<fdinfo_data>& fds_data = data.fds_data;
 
-    if (fds_data.empty())
+    if (data.fds.empty())
         return 0;
 
-    std::string freq_str = fds_data[0]["drm-curfreq-fragment"];
+    size_t slot = data.slot("drm-curfreq-fragment");
 
-    if (freq_str.empty())
+    if (!data.fds[0].has(slot))
         return 0;
 
-    float freq = std::stoull(freq_str) / 1'000'000;
+    float freq = data.fds[0].get(slot) / 1'000'000;
 
     return std::round(freq);
 }
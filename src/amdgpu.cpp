@@ -1,4 +1,5 @@
 #include <spdlog/spdlog.h>
+#include <initializer_list>
 #include <thread>
 #ifdef __linux__
 #include <sys/sysinfo.h>
@@ -13,41 +14,45 @@
 
 
 #define IS_VALID_METRIC(FIELD) (FIELD != 0xffff)
-void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
-	FILE *f;
-    metrics_table_header header {};
-	f = fopen(gpu_metrics_path.c_str(), "rb");
-	if (!f)
-		return;
 
-    size_t nread = fread(&header, 1, sizeof(header), f);
+// FNV-1a over the given table fields, see amdgpu_common_metrics::payload
+static uint64_t hash_payload(std::initializer_list<uint64_t> fields) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (uint64_t field : fields) {
+		for (int i = 0; i < 8; i++) {
+			hash ^= (field >> (i * 8)) & 0xff;
+			hash *= 0x100000001b3ull;
+		}
+	}
+	return hash;
+}
+
+void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
+	metrics_table_header header {};
+	// One pread() of the table through the fd kept open since the constructor
+	std::string_view data = gpu_metrics_file.read();
 
-	if (nread < sizeof(header)) {
+	if (data.size() < sizeof(header)) {
 		SPDLOG_DEBUG("amdgpu metrics file '{}' may be corrupted (read {} bytes, need at least {})",
-			gpu_metrics_path, nread, sizeof(header));
-		fclose(f);
+			gpu_metrics_path, data.size(), sizeof(header));
 		return;
 	}
+	memcpy(&header, data.data(), sizeof(header));
 
-    if (header.structure_size < sizeof(header)) {
-        SPDLOG_DEBUG(
-            "amdgpu metrics file '{}' has invalid structure_size {}",
-            gpu_metrics_path, header.structure_size);
-        fclose(f);
-        return;
-    }
-
-	std::vector<uint8_t> buf(header.structure_size);
-	rewind(f);
-	nread = fread(buf.data(), 1, buf.size(), f);
-	fclose(f);
+	if (header.structure_size < sizeof(header)) {
+		SPDLOG_DEBUG(
+			"amdgpu metrics file '{}' has invalid structure_size {}",
+			gpu_metrics_path, header.structure_size);
+		return;
+	}
 
-	if (nread < buf.size()) {
+	if (data.size() < header.structure_size) {
 		SPDLOG_DEBUG(
-            "amdgpu metrics file '{}' short read (read {} bytes, expected {})",
-            gpu_metrics_path, nread, buf.size());
-        return;
+			"amdgpu metrics file '{}' short read (read {} bytes, expected {})",
+			gpu_metrics_path, data.size(), header.structure_size);
+		return;
 	}
+	std::string_view buf = data.substr(0, header.structure_size);
 
 	bool is_power=false, is_current=false, is_temp=false, is_other=false;
 	if (header.format_revision == 1) {
@@ -71,6 +76,13 @@ void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
 		metrics->gpu_temp_c = amdgpu_metrics->temperature_edge;
 		metrics->fan_speed = amdgpu_metrics->current_fan_speed;
 
+		metrics->energy_accumulator = amdgpu_metrics->energy_accumulator;
+		// The driver stamps every read, the PMFW only when it refreshed the table
+		metrics->timestamp_ns = amdgpu_metrics->firmware_timestamp ?
+			amdgpu_metrics->firmware_timestamp * 10 : amdgpu_metrics->system_clock_counter;
+		metrics->payload = hash_payload({amdgpu_metrics->average_socket_power,
+			amdgpu_metrics->average_gfx_activity});
+
 		uint64_t indep = amdgpu_metrics->indep_throttle_status;
 		// RDNA 3 almost always shows the TEMP_HOTSPOT throtting flag,
 		// so clear that bit
@@ -110,6 +122,12 @@ void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
 		metrics->gpu_load_percent = amdgpu_metrics->average_gfx_activity;
 
 		metrics->average_gfx_power_w = amdgpu_metrics->average_gfx_power / 1000.f;
+		metrics->energy_accumulator = 0;
+		// the driver's read time, the firmware doesn't stamp v2 tables
+		metrics->timestamp_ns = amdgpu_metrics->system_clock_counter;
+		metrics->payload = hash_payload({amdgpu_metrics->average_socket_power,
+			amdgpu_metrics->average_cpu_power, amdgpu_metrics->average_gfx_power,
+			amdgpu_metrics->average_gfx_activity});
 
 		if( IS_VALID_METRIC(amdgpu_metrics->average_cpu_power) ) {
 			// prefered method
@@ -195,7 +213,7 @@ void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
 				gpu_metrics_path, buf.size(), sizeof(gpu_metrics_v3_0));
 			return;
 		}
-		struct gpu_metrics_v3_0 *amdgpu_metrics = (struct gpu_metrics_v3_0 *) buf.data();
+		const struct gpu_metrics_v3_0 *amdgpu_metrics = (const struct gpu_metrics_v3_0 *) buf.data();
 		this->is_apu = true;
 
 		metrics->gpu_temp_c = amdgpu_metrics->temperature_gfx / 100;
@@ -220,6 +238,11 @@ void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
 		metrics->average_gfx_power_w = amdgpu_metrics->average_gfx_power / 1000.0;
 		metrics->current_gfxclk_mhz = amdgpu_metrics->average_gfxclk_frequency;
 		metrics->current_uclk_mhz = amdgpu_metrics->average_uclk_frequency;
+		metrics->energy_accumulator = 0;
+		metrics->timestamp_ns = amdgpu_metrics->system_clock_counter;
+		metrics->payload = hash_payload({amdgpu_metrics->average_socket_power,
+			amdgpu_metrics->average_apu_power, amdgpu_metrics->average_gfx_power,
+			amdgpu_metrics->average_all_core_power, amdgpu_metrics->average_gfx_activity});
 
 		if (previous_metrics.common_header.structure_size == 0) {
 			previous_metrics = *amdgpu_metrics;
@@ -269,116 +292,132 @@ void AMDGPU::get_instant_metrics(struct amdgpu_common_metrics *metrics) {
 	metrics->is_other_throttled   = is_other;
 }
 
-void AMDGPU::get_samples_and_copy(struct amdgpu_common_metrics metrics_buffer[METRICS_SAMPLE_COUNT], bool &gpu_load_needs_dividing) {
-	while (!stop_thread) {
-		// Get all the samples
-		for (size_t cur_sample_id=0; cur_sample_id < METRICS_SAMPLE_COUNT; cur_sample_id++) {
-			if (gpu_metrics_is_valid)
-				get_instant_metrics(&metrics_buffer[cur_sample_id]);
-
-			// Detect and fix if the gpu load is reported in centipercent
-			if (gpu_load_needs_dividing || metrics_buffer[cur_sample_id].gpu_load_percent > 100){
-				gpu_load_needs_dividing = true;
-				metrics_buffer[cur_sample_id].gpu_load_percent /= 100;
-			}
-
-			// frequently check if thread should stop so we don't get stuck for 500ms
-			for (int ms = 0; ms < METRICS_POLLING_PERIOD_MS; ms++) {
-				if (stop_thread) break;
-				usleep(1000);
-			}
+// Integrates GPU energy over the tables the firmware actually refreshed.
+// Polling faster than the PMFW updates returns the same table again, which
+// must not count as a new interval.
+//
+// Without an energy counter (APUs) a table is only recognized as new when
+// its power or activity changed. Repeats are skipped, but the last one
+// shows the old power still held then, so only the time after it is
+// interpolated. The result is still the firmware's filtered power
+// integrated over time, not a measured energy.
+void AMDGPU::accumulate_energy(const struct amdgpu_common_metrics &sample) {
+	struct amdgpu_common_metrics &last = last_energy_sample;
+
+	if (sample.timestamp_ns <= last.timestamp_ns) {
+		// The clock went backwards after a suspend, start over from here
+		if (sample.timestamp_ns < last.timestamp_ns) {
+			last = sample;
+			last_repeat_ns = 0;
 		}
+		return;
+	}
 
-		if (stop_thread) break;
-
-        std::unique_lock<std::mutex> lock(metrics_mutex);
-        cond_var.wait(lock, [this]() { return !paused || stop_thread; });
-		// do one pass of metrics from sysfs nodes
-		// then we replace with GPU metrics if it's available
-		get_sysfs_metrics();
-
-#ifndef TEST_ONLY
-        if (HUDElements.g_gamescopePid > 0 && HUDElements.g_gamescopePid != pid) {
-            pid = HUDElements.g_gamescopePid;
-            fdinfo.add_pid(pid);
-        }
-#endif
-
-    	fdinfo.poll_all();
-		metrics.proc_vram_used = fdinfo.get_memory_used(pid, "drm-memory-vram");
-
-		if (gpu_metrics_is_valid) {
-			UPDATE_METRIC_AVERAGE(gpu_load_percent);
-			UPDATE_METRIC_AVERAGE_FLOAT(average_gfx_power_w);
-			UPDATE_METRIC_AVERAGE_FLOAT(average_cpu_power_w);
+	bool has_accumulator = sample.energy_accumulator != 0 && sample.energy_accumulator != UINT64_MAX;
+	// The driver stamps every read, so an unchanged counter or payload is the old table
+	if (has_accumulator && sample.energy_accumulator == last.energy_accumulator)
+		return;
+	if (!has_accumulator && last.timestamp_ns != 0 && sample.payload == last.payload) {
+		last_repeat_ns = sample.timestamp_ns;
+		return;
+	}
 
-			UPDATE_METRIC_AVERAGE(current_gfxclk_mhz);
-			UPDATE_METRIC_AVERAGE(current_uclk_mhz);
+	// The first table is only the baseline
+	if (last.timestamp_ns == 0) {
+		last = sample;
+		return;
+	}
 
-			UPDATE_METRIC_AVERAGE(soc_temp_c);
-			UPDATE_METRIC_AVERAGE(gpu_temp_c);
-			UPDATE_METRIC_AVERAGE(apu_cpu_temp_c);
+	double joules;
+	bool exact = has_accumulator && last.energy_accumulator != 0 &&
+		sample.energy_accumulator > last.energy_accumulator;
+	if (exact) {
+		joules = (sample.energy_accumulator - last.energy_accumulator) / 65536.0;
+	} else {
+		// No counter on APUs (or it wrapped), use the firmware's averaged power
+		uint64_t held_ns = std::max(last_repeat_ns, last.timestamp_ns);
+		joules = last.average_gfx_power_w * ((held_ns - last.timestamp_ns) / 1e9) +
+			(sample.average_gfx_power_w + last.average_gfx_power_w) / 2.0 * ((sample.timestamp_ns - held_ns) / 1e9);
+	}
+	last = sample;
+	last_repeat_ns = 0;
 
-			UPDATE_METRIC_MAX(is_power_throttled);
-			UPDATE_METRIC_MAX(is_current_throttled);
-			UPDATE_METRIC_MAX(is_temp_throttled);
-			UPDATE_METRIC_MAX(is_other_throttled);
+	std::lock_guard<std::mutex> lock(energy_mutex);
+	energy_total.joules += joules;
+	energy_total.timestamp_ns = sample.timestamp_ns;
+	energy_total.exact = exact;
+}
 
-			UPDATE_METRIC_MAX(fan_speed);
-			metrics.fan_rpm = true;
+unsigned AMDGPU::sample_period_ms() const {
+#ifndef TEST_ONLY
+	// Only gpu_metrics is cheap enough to read at a high rate
+	if (gpu_metrics_is_valid)
+		return get_params()->gpu_sample_period;
+#endif
+	return METRICS_UPDATE_PERIOD_MS;
+}
 
-			metrics.load = amdgpu_common_metrics.gpu_load_percent;
-			metrics.powerUsage = amdgpu_common_metrics.average_gfx_power_w;
-			metrics.MemClock = amdgpu_common_metrics.current_uclk_mhz;
+// The sysfs nodes and fdinfo are slow to read and don't change as fast,
+// they keep the METRICS_UPDATE_PERIOD_MS cadence
+void AMDGPU::update(gpu_metrics &metrics) {
+	// do one pass of metrics from sysfs nodes
+	// then we replace with GPU metrics if it's available
+	get_sysfs_metrics(metrics);
 
-			// Use hwmon instead, see gpu.cpp
-			if ( device_id == 0x1435 || device_id == 0x163f )
-			{
-				// If we are on VANGOGH (Steam Deck), then
-				// always use core clock from GPU metrics.
-				metrics.CoreClock = amdgpu_common_metrics.current_gfxclk_mhz;
-			}
-			metrics.temp = amdgpu_common_metrics.gpu_temp_c;
-			metrics.apu_cpu_power = amdgpu_common_metrics.average_cpu_power_w;
-			metrics.apu_cpu_temp = amdgpu_common_metrics.apu_cpu_temp_c;
-
-			metrics.is_power_throttled = amdgpu_common_metrics.is_power_throttled;
-			metrics.is_current_throttled = amdgpu_common_metrics.is_current_throttled;
-			metrics.is_temp_throttled = amdgpu_common_metrics.is_temp_throttled;
-			metrics.is_other_throttled = amdgpu_common_metrics.is_other_throttled;
-
-			// Set only if gpu_metrics has value larger than 0, otherwise use hwmon
-			if (amdgpu_common_metrics.fan_speed > 0)
-				metrics.fan_speed = amdgpu_common_metrics.fan_speed;
-		}
+#ifndef TEST_ONLY
+	if (HUDElements.g_gamescopePid > 0 && HUDElements.g_gamescopePid != pid) {
+		pid = HUDElements.g_gamescopePid;
+		fdinfo.add_pid(pid);
 	}
+#endif
+
+	fdinfo.poll_all();
+	metrics.proc_vram_used = fdinfo.get_memory_used(pid, "drm-memory-vram");
 }
 
-void AMDGPU::metrics_polling_thread() {
-	struct amdgpu_common_metrics metrics_buffer[METRICS_SAMPLE_COUNT];
-	bool gpu_load_needs_dividing = false;  //some GPUs report load as centipercent
+void AMDGPU::sample(gpu_metrics &metrics) {
+	if (!gpu_metrics_is_valid)
+		return;
 
-	// Initial poll of the metrics, so that we have values to display as fast as possible
+	// Fields missing from this revision keep their previous value
 	get_instant_metrics(&amdgpu_common_metrics);
-	if (amdgpu_common_metrics.gpu_load_percent > 100){
+	accumulate_energy(amdgpu_common_metrics);
+
+	// Detect and fix if the gpu load is reported in centipercent
+	uint16_t load = amdgpu_common_metrics.gpu_load_percent;
+	if (gpu_load_needs_dividing || load > 100) {
 		gpu_load_needs_dividing = true;
-		amdgpu_common_metrics.gpu_load_percent /= 100;
+		load /= 100;
 	}
 
-	// Set all the fields to 0 by default. Only done once as we're just replacing previous values after
-	memset(metrics_buffer, 0, sizeof(metrics_buffer));
+	metrics.fan_rpm = true;
 
-	while (!stop_thread) {
-#ifndef TEST_ONLY
-		if (get_params()->no_display && !logger->is_active())
-			usleep(100000);
-		else
-#endif
-			get_samples_and_copy(metrics_buffer, gpu_load_needs_dividing);
+	metrics.load = load;
+	metrics.powerUsage = amdgpu_common_metrics.average_gfx_power_w;
+	metrics.MemClock = amdgpu_common_metrics.current_uclk_mhz;
+
+	// Use hwmon instead, see gpu.cpp
+	if ( device_id == 0x1435 || device_id == 0x163f )
+	{
+		// If we are on VANGOGH (Steam Deck), then
+		// always use core clock from GPU metrics.
+		metrics.CoreClock = amdgpu_common_metrics.current_gfxclk_mhz;
 	}
+	metrics.temp = amdgpu_common_metrics.gpu_temp_c;
+	metrics.apu_cpu_power = amdgpu_common_metrics.average_cpu_power_w;
+	metrics.apu_cpu_temp = amdgpu_common_metrics.apu_cpu_temp_c;
+
+	metrics.is_power_throttled = amdgpu_common_metrics.is_power_throttled;
+	metrics.is_current_throttled = amdgpu_common_metrics.is_current_throttled;
+	metrics.is_temp_throttled = amdgpu_common_metrics.is_temp_throttled;
+	metrics.is_other_throttled = amdgpu_common_metrics.is_other_throttled;
+
+	// Set only if gpu_metrics has value larger than 0, otherwise use hwmon
+	if (amdgpu_common_metrics.fan_speed > 0)
+		metrics.fan_speed = amdgpu_common_metrics.fan_speed;
 }
 
-void AMDGPU::get_sysfs_metrics() {
+void AMDGPU::get_sysfs_metrics(gpu_metrics &metrics) {
     int64_t value = 0;
 	if (sysfs_nodes.busy) {
 		rewind(sysfs_nodes.busy);
@@ -519,15 +558,12 @@ AMDGPU::AMDGPU(std::string pci_dev, uint32_t device_id, uint32_t vendor_id, std:
 	this->vendor_id = vendor_id;
 	const std::string device_path = "/sys/bus/pci/devices/" + pci_dev;
 	gpu_metrics_path = device_path + "/gpu_metrics";
-    // Just check that the metrics file exists and is readable
-    FILE *f = fopen(gpu_metrics_path.c_str(), "rb");
-    if (f) {
-        gpu_metrics_is_valid = true;
-        fclose(f);
-    } else {
-        gpu_metrics_is_valid = false;
-        SPDLOG_DEBUG("Failed to open gpu_metrics at '{}'", gpu_metrics_path);
-    }
+	// Kept open for the lifetime of the sampler, each sample is one pread()
+	if (!gpu_metrics_file.open(gpu_metrics_path)) {
+		SPDLOG_DEBUG("Failed to open gpu_metrics at '{}'", gpu_metrics_path);
+	} else {
+		gpu_metrics_is_valid = true;
+	}
 
 	sysfs_nodes.busy = fopen((device_path + "/gpu_busy_percent").c_str(), "r");
 	sysfs_nodes.vram_total = fopen((device_path + "/mem_info_vram_total").c_str(), "r");
@@ -563,6 +599,4 @@ AMDGPU::AMDGPU(std::string pci_dev, uint32_t device_id, uint32_t vendor_id, std:
 	fdinfo.add_pid(pid);
 
 	throttling = std::make_shared<Throttling>(0x1002);
-	thread = std::thread(&AMDGPU::metrics_polling_thread, this);
-	pthread_setname_np(thread.native_handle(), "mangohud-amdgpu");
 }
@@ -12,15 +12,13 @@
 #include <atomic>
 #include <thread>
 #include "gpu_metrics_util.h"
+#include "file_utils.h"
+#include "gpu_sampler.h"
 
 #include "../mangohud-next/legacy_gpu_wrapper/wrapper.hpp"
 
 #define NUM_HBM_INSTANCES 4
 #define TEMP_HOTSPOT_BIT 36ull
-#define UPDATE_METRIC_AVERAGE(FIELD) do { int value_sum = 0; for (size_t s=0; s < METRICS_SAMPLE_COUNT; s++) { value_sum += metrics_buffer[s].FIELD; } amdgpu_common_metrics.FIELD = value_sum / METRICS_SAMPLE_COUNT; } while(0)
-#define UPDATE_METRIC_AVERAGE_FLOAT(FIELD) do { float value_sum = 0; for (size_t s=0; s < METRICS_SAMPLE_COUNT; s++) { value_sum += metrics_buffer[s].FIELD; } amdgpu_common_metrics.FIELD = value_sum / METRICS_SAMPLE_COUNT; } while(0)
-#define UPDATE_METRIC_MAX(FIELD) do { int cur_max = metrics_buffer[0].FIELD; for (size_t s=1; s < METRICS_SAMPLE_COUNT; s++) { cur_max = MAX(cur_max, metrics_buffer[s].FIELD); }; amdgpu_common_metrics.FIELD = cur_max; } while(0)
-#define UPDATE_METRIC_LAST(FIELD) do { amdgpu_common_metrics.FIELD = metrics_buffer[METRICS_SAMPLE_COUNT - 1].FIELD; } while(0)
 #ifdef _WIN32
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #endif
@@ -468,63 +466,72 @@ struct amdgpu_common_metrics {
 	bool is_other_throttled;
 
 	uint16_t fan_speed;
+
+	/* Energy: raw counters, see AMDGPU::accumulate_energy() */
+	uint64_t energy_accumulator; /* 2^-16 J units, 0 if not reported */
+	uint64_t timestamp_ns; /* when the firmware produced this table */
+	/* Hash of the table's power and activity fields. Without an energy
+	 * counter or firmware timestamp (APUs) it is the only way to tell a
+	 * refreshed table from the same one read again. */
+	uint64_t payload;
+};
+
+/* GPU energy used since the sampler started. Two of these give the exact
+ * average power between them, independent of the firmware's own filtering.
+ */
+struct amdgpu_energy {
+	double joules;
+	uint64_t timestamp_ns; /* of the last table that advanced it */
+	bool exact; /* integrated from energy_accumulator rather than power */
+
+	static float average_power(const amdgpu_energy &from, const amdgpu_energy &to) {
+		if (to.timestamp_ns <= from.timestamp_ns)
+			return 0.f;
+		return (to.joules - from.joules) / ((to.timestamp_ns - from.timestamp_ns) / 1e9);
+	}
 };
 
 extern std::string metrics_path;
 
-class AMDGPU {
+class AMDGPU : public GpuSource {
 	public:
 		bool is_apu = false;
 		std::shared_ptr<Throttling> throttling;
 
     	AMDGPU(std::string pci_dev, uint32_t device_id, uint32_t vendor_id, std::string drm_node);
 
-		~AMDGPU() {
-			stop_thread = true;
-			if (thread.joinable())
-				thread.join();
-		}
-
 		void get_instant_metrics(struct amdgpu_common_metrics *metrics);
-		void get_samples_and_copy(struct amdgpu_common_metrics metrics_buffer[METRICS_SAMPLE_COUNT],
-								  bool &gpu_load_needs_dividing);
-
-        gpu_metrics copy_metrics() {
-            std::lock_guard<std::mutex> lock(metrics_mutex);
-            return metrics;
-        };
 
-        void pause() {
-            paused = true;
-            cond_var.notify_one();
-        };
+		unsigned sample_period_ms() const override;
+		void sample(gpu_metrics &metrics) override;
+		void update(gpu_metrics &metrics) override;
 
-        void resume() {
-            paused = false;
-            cond_var.notify_one();
-        }
+		amdgpu_energy energy() {
+			std::lock_guard<std::mutex> lock(energy_mutex);
+			return energy_total;
+		}
 
 	private:
 		std::string pci_dev;
 		std::string gpu_metrics_path;
+		persistent_file gpu_metrics_file;
 		uint32_t device_id;
 		uint32_t vendor_id;
-		std::condition_variable amdgpu_c;
-		std::thread thread;
 		struct amdgpu_files sysfs_nodes = {};
 		bool gpu_metrics_is_valid = false;
-		std::condition_variable cond_var;
-		std::atomic<bool> stop_thread{false};
-        std::atomic<bool> paused{false};
-		std::mutex metrics_mutex;
-		gpu_metrics metrics;
+		bool gpu_load_needs_dividing = false;  //some GPUs report load as centipercent
 		pid_t pid = getpid();
 		LegacyFDInfoWrapper fdinfo;
-		struct amdgpu_common_metrics amdgpu_common_metrics;
+		struct amdgpu_common_metrics amdgpu_common_metrics {};
 		struct gpu_metrics_v3_0 previous_metrics{};
 		#define V3_THROTTLING_DELTA(name) \
 		((amdgpu_metrics)->throttle_residency_##name - (previous_metrics).throttle_residency_##name)
 
-		void get_sysfs_metrics();
-		void metrics_polling_thread();
+		std::mutex energy_mutex;
+		amdgpu_energy energy_total {};
+		struct amdgpu_common_metrics last_energy_sample {};
+		uint64_t last_repeat_ns = 0; /* last read that repeated last_energy_sample */
+
+		void accumulate_energy(const struct amdgpu_common_metrics &sample);
+		void get_sysfs_metrics(gpu_metrics &metrics);
 };
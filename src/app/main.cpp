@@ -157,6 +157,7 @@ static void gamescope_frametime(uint64_t app_frametime_ns, uint64_t latency_ns){
     {
         float app_frametime_ms = app_frametime_ns / 1000000.f;
         HUDElements.gamescope_debug_app.push_back(app_frametime_ms);
+        HUDElements.gamescope_app_frametime_ms = app_frametime_ms;
         if (HUDElements.gamescope_debug_app.size() > 200)
             HUDElements.gamescope_debug_app.erase(HUDElements.gamescope_debug_app.begin());
     }
@@ -165,6 +166,7 @@ static void gamescope_frametime(uint64_t app_frametime_ns, uint64_t latency_ns){
     if (latency_ns == uint64_t(-1))
         latency_ms = -1;
     HUDElements.gamescope_debug_latency.push_back(latency_ms);
+    HUDElements.gamescope_latency_ms = latency_ms;
     if (HUDElements.gamescope_debug_latency.size() > 200)
         HUDElements.gamescope_debug_latency.erase(HUDElements.gamescope_debug_latency.begin());
 }
@@ -7,7 +7,6 @@
 #include <dirent.h>
 #include <string.h>
 #include <algorithm>
-#include <regex>
 #include <inttypes.h>
 #include <spdlog/spdlog.h>
 #include "string_utils.h"
@@ -35,72 +34,7 @@
 #endif
 
 #include "file_utils.h"
-
-static void calculateCPUData(CPUData& cpuData,
-    unsigned long long int usertime,
-    unsigned long long int nicetime,
-    unsigned long long int systemtime,
-    unsigned long long int idletime,
-    unsigned long long int ioWait,
-    unsigned long long int irq,
-    unsigned long long int softIrq,
-    unsigned long long int steal,
-    unsigned long long int guest,
-    unsigned long long int guestnice)
-{
-    // Guest time is already accounted in usertime
-    usertime = usertime - guest;
-    nicetime = nicetime - guestnice;
-    // Fields existing on kernels >= 2.6
-    // (and RHEL's patched kernel 2.4...)
-    unsigned long long int idlealltime = idletime + ioWait;
-    unsigned long long int systemalltime = systemtime + irq + softIrq;
-    unsigned long long int virtalltime = guest + guestnice;
-    unsigned long long int totaltime = usertime + nicetime + systemalltime + idlealltime + steal + virtalltime;
-
-    // Since we do a subtraction (usertime - guest) and cputime64_to_clock_t()
-    // used in /proc/stat rounds down numbers, it can lead to a case where the
-    // integer overflow.
-    #define WRAP_SUBTRACT(a,b) (a > b) ? a - b : 0
-    cpuData.userPeriod = WRAP_SUBTRACT(usertime, cpuData.userTime);
-    cpuData.nicePeriod = WRAP_SUBTRACT(nicetime, cpuData.niceTime);
-    cpuData.systemPeriod = WRAP_SUBTRACT(systemtime, cpuData.systemTime);
-    cpuData.systemAllPeriod = WRAP_SUBTRACT(systemalltime, cpuData.systemAllTime);
-    cpuData.idleAllPeriod = WRAP_SUBTRACT(idlealltime, cpuData.idleAllTime);
-    cpuData.idlePeriod = WRAP_SUBTRACT(idletime, cpuData.idleTime);
-    cpuData.ioWaitPeriod = WRAP_SUBTRACT(ioWait, cpuData.ioWaitTime);
-    cpuData.irqPeriod = WRAP_SUBTRACT(irq, cpuData.irqTime);
-    cpuData.softIrqPeriod = WRAP_SUBTRACT(softIrq, cpuData.softIrqTime);
-    cpuData.stealPeriod = WRAP_SUBTRACT(steal, cpuData.stealTime);
-    cpuData.guestPeriod = WRAP_SUBTRACT(virtalltime, cpuData.guestTime);
-    cpuData.totalPeriod = WRAP_SUBTRACT(totaltime, cpuData.totalTime);
-    #undef WRAP_SUBTRACT
-    cpuData.userTime = usertime;
-    cpuData.niceTime = nicetime;
-    cpuData.systemTime = systemtime;
-    cpuData.systemAllTime = systemalltime;
-    cpuData.idleAllTime = idlealltime;
-    cpuData.idleTime = idletime;
-    cpuData.ioWaitTime = ioWait;
-    cpuData.irqTime = irq;
-    cpuData.softIrqTime = softIrq;
-    cpuData.stealTime = steal;
-    cpuData.guestTime = virtalltime;
-    cpuData.totalTime = totaltime;
-
-    if (cpuData.totalPeriod == 0)
-        return;
-    float total = (float)cpuData.totalPeriod;
-    float v[4];
-    v[0] = cpuData.nicePeriod * 100.0f / total;
-    v[1] = cpuData.userPeriod * 100.0f / total;
-
-    /* if not detailed */
-    v[2] = cpuData.systemAllPeriod * 100.0f / total;
-    v[3] = (cpuData.stealPeriod + cpuData.guestPeriod) * 100.0f / total;
-    //cpuData.percent = std::clamp(v[0]+v[1]+v[2]+v[3], 0.0f, 100.0f);
-    cpuData.percent = std::min(std::max(v[0]+v[1]+v[2]+v[3], 0.0f), 100.0f);
-}
+#include "proc_stat.h"
 
 CPUStats::CPUStats()
 {
@@ -140,8 +74,6 @@ bool CPUStats::Init()
             }
 
             CPUData cpu = {};
-            cpu.totalTime = 1;
-            cpu.totalPeriod = 1;
             sscanf(line.c_str(), "cpu%4d ", &cpu.cpu_id);
             m_cpuData.push_back(cpu);
 
@@ -177,99 +109,102 @@ bool CPUStats::Reinit()
 //TODO take sampling interval into account?
 bool CPUStats::UpdateCPUData()
 {
-    unsigned long long int usertime, nicetime, systemtime, idletime;
-    unsigned long long int ioWait, irq, softIrq, steal, guest, guestnice;
-    int cpuid = -1;
-    size_t cpu_count = 0;
-
     if (!m_inited)
         return false;
 
-    std::string line;
-    std::ifstream file (PROCSTATFILE);
-    bool ret = false;
-
-    if (!file.is_open()) {
+    if (!m_procStat.is_open() && !m_procStat.open(PROCSTATFILE)) {
         SPDLOG_ERROR("Failed to opening " PROCSTATFILE);
         return false;
     }
 
-    do {
-        if (!std::getline(file, line)) {
-            break;
-        } else if (!ret && sscanf(line.c_str(), "cpu  %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
-            &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 10) {
-            ret = true;
-            calculateCPUData(m_cpuDataTotal, usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
-        } else if (sscanf(line.c_str(), "cpu%4d %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu %16llu",
-            &cpuid, &usertime, &nicetime, &systemtime, &idletime, &ioWait, &irq, &softIrq, &steal, &guest, &guestnice) == 11) {
-
-            //SPDLOG_DEBUG("Parsing 'cpu{}' line:{}", cpuid, line);
-
-            if (!ret) {
-                SPDLOG_DEBUG("Failed to parse 'cpu' line:{}", line);
-                return false;
-            }
+    auto& stat = m_procStatCounters;
+    if (!parse_proc_stat(m_procStat.read(), stat)) {
+        SPDLOG_DEBUG("Failed to parse 'cpu' line of " PROCSTATFILE);
+        return false;
+    }
 
-            if (cpuid < 0 /* can it? */) {
-                SPDLOG_DEBUG("Cpu id '{}' is out of bounds", cpuid);
-                return false;
-            }
+    for (size_t i = 0; i < stat.size(); i++) {
+        if (i >= m_cpuData.size() || m_cpuData[i].cpu_id != stat.cpu_id[i]) {
+            SPDLOG_DEBUG("Cpu id '{}' is out of bounds or wrong index, reiniting", stat.cpu_id[i]);
+            return Reinit();
+        }
+    }
 
-            if (cpu_count + 1 > m_cpuData.size() || m_cpuData[cpu_count].cpu_id != cpuid) {
-                SPDLOG_DEBUG("Cpu id '{}' is out of bounds or wrong index, reiniting", cpuid);
-                return Reinit();
-            }
+    if (stat.size() < m_cpuData.size())
+        m_cpuData.resize(stat.size());
 
-            CPUData& cpuData = m_cpuData[cpu_count];
-            calculateCPUData(cpuData, usertime, nicetime, systemtime, idletime, ioWait, irq, softIrq, steal, guest, guestnice);
-            cpuid = -1;
-            cpu_count++;
+    m_procStatLoad.update(stat);
+    m_cpuDataTotal.percent = m_procStatLoad.all_load;
+    if (!m_cpuData.empty())
+        m_cpuPeriod = (double)m_procStatLoad.period[0] / m_cpuData.size();
+    m_updatedCPUs = true;
+    return true;
+}
 
-        } else {
-            break;
+// Opens `file` of every cpu's cpufreq directory, fails if any is missing
+static bool open_cpufreq_files(const std::vector<CPUData>& cpus, const char* file, std::vector<persistent_file>& files)
+{
+    files.clear();
+    for (auto& cpu : cpus) {
+        files.emplace_back("/sys/devices/system/cpu/cpu" + std::to_string(cpu.cpu_id) + "/cpufreq/" + file);
+        if (!files.back().is_open()) {
+            files.clear();
+            return false;
         }
-    } while(true);
-
-    if (cpu_count < m_cpuData.size())
-        m_cpuData.resize(cpu_count);
+    }
+    return !files.empty();
+}
 
-    m_cpuPeriod = (double)m_cpuData[0].totalPeriod / m_cpuData.size();
-    m_updatedCPUs = true;
-    return ret;
+void CPUStats::OpenCoreFreqFiles() {
+    // cpuinfo_avg_freq is the kernel's APERF/MPERF (x86) or AMU (arm64)
+    // average over the last tick, scaling_cur_freq is the cpufreq request
+    // or the same average depending on the driver
+    if (open_cpufreq_files(m_cpuData, "cpuinfo_avg_freq", m_coreFreqFiles))
+        m_coreFreqSource = CORE_FREQ_AVG;
+    else if (open_cpufreq_files(m_cpuData, "scaling_cur_freq", m_coreFreqFiles))
+        m_coreFreqSource = CORE_FREQ_SCALING;
+    else if (m_coreFreqFiles.emplace_back(PROCCPUINFOFILE).is_open())
+        m_coreFreqSource = CORE_FREQ_CPUINFO;
+    else
+        m_coreFreqSource = CORE_FREQ_NONE;
+
+    SPDLOG_DEBUG("core frequency source: {}", int(m_coreFreqSource));
 }
 
 bool CPUStats::UpdateCoreMhz() {
     m_coreMhz.clear();
-    FILE *fp;
-    static bool scaling_freq = true;
-    if (scaling_freq){
-        for (auto& cpu : m_cpuData){
-            std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu.cpu_id) + "/cpufreq/scaling_cur_freq";
-            if ((fp = fopen(path.c_str(), "r"))){
-                int64_t temp;
-                if (fscanf(fp, "%" PRId64, &temp) != 1)
-                    temp = 0;
-                cpu.mhz = temp / 1000;
-                fclose(fp);
-                scaling_freq = true;
-            } else {
-                scaling_freq = false;
-                break;
-            }
+
+    // cpus can go away on Reinit(), reopen everything then
+    bool per_cpu = m_coreFreqSource == CORE_FREQ_AVG || m_coreFreqSource == CORE_FREQ_SCALING;
+    if (m_coreFreqSource == CORE_FREQ_UNKNOWN || (per_cpu && m_coreFreqFiles.size() != m_cpuData.size()))
+        OpenCoreFreqFiles();
+
+    switch (m_coreFreqSource) {
+    case CORE_FREQ_AVG:
+    case CORE_FREQ_SCALING:
+        for (size_t i = 0; i < m_cpuData.size(); i++) {
+            auto contents = m_coreFreqFiles[i].read();
+            uint64_t khz;
+            m_cpuData[i].mhz = scan_u64(contents, khz) ? khz / 1000 : 0;
         }
-    } else {
-        static std::ifstream cpuInfo(PROCCPUINFOFILE);
-        static std::string row;
+        break;
+    case CORE_FREQ_CPUINFO: {
+        // "cpu MHz\t\t: 3400.000", one per processor in cpu order
+        auto contents = m_coreFreqFiles[0].read();
         size_t i = 0;
-        while (std::getline(cpuInfo, row) && i < m_cpuData.size()) {
-            if (row.find("MHz") != std::string::npos){
-                row = std::regex_replace(row, std::regex(R"([^0-9.])"), "");
-                if (!try_stoi(m_cpuData[i].mhz, row))
-                    m_cpuData[i].mhz = 0;
-                i++;
-            }
+        while (!contents.empty() && i < m_cpuData.size()) {
+            auto line = next_line(contents);
+            if (line.find("MHz") == std::string_view::npos)
+                continue;
+            auto sep = line.find(':');
+            auto value = line.substr(sep == std::string_view::npos ? line.size() : sep + 1);
+            uint64_t mhz;
+            m_cpuData[i++].mhz = scan_u64(value, mhz) ? mhz : 0;
         }
+        break;
+    }
+    default:
+        break;
     }
 
     m_cpuDataTotal.cpu_mhz = 0;
@@ -537,6 +472,16 @@ static bool find_fallback_input(const std::string& path, const char* input_prefi
     return false;
 }
 
+// matches cpu\d*_thermal
+static bool is_cpu_thermal(std::string_view name) {
+    if (name.substr(0, 3) != "cpu")
+        return false;
+    name.remove_prefix(3);
+    while (!name.empty() && name[0] >= '0' && name[0] <= '9')
+        name.remove_prefix(1);
+    return name == "_thermal";
+}
+
 static void check_thermal_zones(std::string& path, std::string& input) {
     std::string sysfs_thermal = "/sys/class/thermal/";
 
@@ -564,7 +509,6 @@ bool CPUStats::GetCpuFile() {
 
     std::string name, path, input;
     std::string hwmon = "/sys/class/hwmon/";
-    std::smatch match;
 
     auto dirs = ls(hwmon.c_str());
     for (auto& dir : dirs) {
@@ -609,7 +553,7 @@ bool CPUStats::GetCpuFile() {
             // E2K (Elbrus 2000) CPU temperature module
             find_input(path, "temp", input, "Node 0 Max");
             break;
-        } else if (std::regex_match(name, match, std::regex("cpu\\d*_thermal"))) {
+        } else if (is_cpu_thermal(name)) {
             find_fallback_input(path, "temp1", input);
             break;
         } else if (name == "apm_xgene") {
@@ -12,35 +12,12 @@
 #endif
 #include "timing.hpp"
 #include "gpu.h"
+#include "file_utils.h"
+#include "proc_stat.h"
 
 typedef struct CPUData_ {
-   unsigned long long int totalTime;
-   unsigned long long int userTime;
-   unsigned long long int systemTime;
-   unsigned long long int systemAllTime;
-   unsigned long long int idleAllTime;
-   unsigned long long int idleTime;
-   unsigned long long int niceTime;
-   unsigned long long int ioWaitTime;
-   unsigned long long int irqTime;
-   unsigned long long int softIrqTime;
-   unsigned long long int stealTime;
-   unsigned long long int guestTime;
-
-   unsigned long long int totalPeriod;
-   unsigned long long int userPeriod;
-   unsigned long long int systemPeriod;
-   unsigned long long int systemAllPeriod;
-   unsigned long long int idleAllPeriod;
-   unsigned long long int idlePeriod;
-   unsigned long long int nicePeriod;
-   unsigned long long int ioWaitPeriod;
-   unsigned long long int irqPeriod;
-   unsigned long long int softIrqPeriod;
-   unsigned long long int stealPeriod;
-   unsigned long long int guestPeriod;
-
    int cpu_id;
+   // only set for GetCPUDataTotal(), per core loads are in GetCoreLoad()
    float percent;
    int mhz;
    int temp;
@@ -50,6 +27,14 @@ typedef struct CPUData_ {
    std::string label = "unknown";
 } CPUData;
 
+enum core_freq_source {
+   CORE_FREQ_UNKNOWN,
+   CORE_FREQ_NONE,
+   CORE_FREQ_AVG,       // cpufreq/cpuinfo_avg_freq
+   CORE_FREQ_SCALING,   // cpufreq/scaling_cur_freq
+   CORE_FREQ_CPUINFO,   // "cpu MHz" lines of /proc/cpuinfo
+};
+
 enum {
    CPU_POWER_K10TEMP,
    CPU_POWER_ZENPOWER,
@@ -176,6 +161,7 @@ public:
 
    bool UpdateCPUData();
    bool UpdateCoreMhz();
+   void OpenCoreFreqFiles();
    bool UpdateCpuTemp();
    bool UpdateCpuPower();
    bool ReadcpuTempFile(int& temp);
@@ -192,6 +178,10 @@ public:
    const CPUData& GetCPUDataTotal() const {
       return m_cpuDataTotal;
    }
+   // Load in percent of each entry of GetCPUData(), contiguous for plotting
+   const std::vector<float>& GetCoreLoad() const {
+      return m_procStatLoad.load;
+   }
 private:
    unsigned long long int m_boottime = 0;
    std::vector<CPUData> m_cpuData;
@@ -202,6 +192,15 @@ private:
    bool m_inited = false;
    FILE *m_cpuTempFile = nullptr;
    std::unique_ptr<CPUPowerData> m_cpuPowerData;
+#ifndef WIN32
+   persistent_file m_procStat;
+   proc_stat_counters m_procStatCounters;
+#endif
+   proc_stat_load m_procStatLoad;
+#ifndef WIN32
+   std::vector<persistent_file> m_coreFreqFiles;
+   core_freq_source m_coreFreqSource = CORE_FREQ_UNKNOWN;
+#endif
 
    const std::map<std::string, std::string> intel_cores = {
       {"P", "/sys/devices/cpu_core/cpus"},
@@ -4,6 +4,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <limits.h>
 #include <fstream>
 #include <cstring>
@@ -220,3 +222,111 @@ std::string to_lower(const std::string& str) {
 }
 
 #endif // __linux__
+
+persistent_file::persistent_file(persistent_file&& other) noexcept
+    : m_fd(other.m_fd), m_path(std::move(other.m_path)), m_buf(std::move(other.m_buf))
+{
+    other.m_fd = -1;
+}
+
+persistent_file& persistent_file::operator=(persistent_file&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        m_path = std::move(other.m_path);
+        m_buf = std::move(other.m_buf);
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+bool persistent_file::open(const std::string& path)
+{
+    close();
+    m_path = path;
+    m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        SPDLOG_DEBUG("Failed to open {}: {}", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void persistent_file::close()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+std::string_view persistent_file::read()
+{
+    if (m_fd < 0)
+        return {};
+
+    if (m_buf.empty())
+        m_buf.resize(4096);
+
+    size_t size = 0;
+    while (true) {
+        ssize_t n = pread(m_fd, m_buf.data() + size, m_buf.size() - size, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            SPDLOG_DEBUG("Failed to read {}: {}", m_path, strerror(errno));
+            return {};
+        }
+        size += n;
+        if (n == 0 || size < m_buf.size())
+            break;
+        // Filled the buffer, the file may be longer
+        m_buf.resize(m_buf.size() * 2);
+    }
+    return {m_buf.data(), size};
+}
+
+static void skip_blanks(std::string_view& s)
+{
+    size_t i = 0;
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t'))
+        i++;
+    s.remove_prefix(i);
+}
+
+bool scan_u64(std::string_view& s, uint64_t& value)
+{
+    skip_blanks(s);
+    size_t i = 0;
+    uint64_t v = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9')
+        v = v * 10 + (s[i++] - '0');
+    if (i == 0)
+        return false;
+    s.remove_prefix(i);
+    value = v;
+    return true;
+}
+
+bool scan_i64(std::string_view& s, int64_t& value)
+{
+    skip_blanks(s);
+    auto rest = s;
+    bool negative = !rest.empty() && rest[0] == '-';
+    if (negative)
+        rest.remove_prefix(1);
+    uint64_t v;
+    if (!scan_u64(rest, v))
+        return false;
+    s = rest;
+    value = negative ? -int64_t(v) : int64_t(v);
+    return true;
+}
+
+std::string_view next_line(std::string_view& s)
+{
+    auto end = s.find('\n');
+    auto line = s.substr(0, end);
+    s.remove_prefix(end == std::string_view::npos ? s.size() : end + 1);
+    return line;
+}
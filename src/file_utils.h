@@ -2,7 +2,9 @@
 #ifndef MANGOHUD_FILE_UTILS_H
 #define MANGOHUD_FILE_UTILS_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <regex>
 #include <array>
@@ -31,4 +33,36 @@ bool lib_loaded(const std::string& lib, pid_t pid);
 std::string remove_parentheses(const std::string&);
 std::string to_lower(const std::string& str);
 
+// Keeps a procfs/sysfs file open and re-reads it from the start with pread()
+// into a reused buffer, for files that are polled over and over.
+class persistent_file {
+public:
+    persistent_file() = default;
+    explicit persistent_file(const std::string& path) { open(path); }
+    ~persistent_file() { close(); }
+    persistent_file(persistent_file&& other) noexcept;
+    persistent_file& operator=(persistent_file&& other) noexcept;
+    persistent_file(const persistent_file&) = delete;
+    persistent_file& operator=(const persistent_file&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return m_fd >= 0; }
+    const std::string& path() const { return m_path; }
+    // Whole file contents, valid until the next read(). Empty on error.
+    std::string_view read();
+
+private:
+    int m_fd = -1;
+    std::string m_path;
+    std::vector<char> m_buf;
+};
+
+// Scanners for the plain text numbers of procfs/sysfs. They skip leading
+// blanks, consume the number from `s` and return false if there isn't one.
+bool scan_u64(std::string_view& s, uint64_t& value);
+bool scan_i64(std::string_view& s, int64_t& value);
+// Consumes and returns the next line of `s`, without the newline
+std::string_view next_line(std::string_view& s);
+
 #endif //MANGOHUD_FILE_UTILS_H
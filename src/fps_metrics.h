@@ -8,89 +8,91 @@
 #include <mutex>
 #include <algorithm>
 #include <condition_variable>
+#include <atomic>
 #include <stdexcept>
 #include <iomanip>
 #include <spdlog/spdlog.h>
+#include "quantile_sketch.h"
 
 struct metric_t {
     std::string name;
     float value;
     std::string display_name;
+    // requested percentile as a fraction, unused for AVG
+    float fraction = 0.f;
 };
 
 class fpsMetrics {
     private:
+        // last max_size frametimes, oldest entry at frametimes_head once full
         std::vector<float> frametimes;
+        size_t frametimes_head = 0;
+        quantile_sketch sketch;
+        // worker's copy of sketch, calculated from outside of mtx
+        quantile_sketch scratch;
         std::thread thread;
+        // guards frametimes and sketch, held only for short sections
         std::mutex mtx;
-        std::condition_variable cv;
-        bool run = false;
-        bool thread_init = false;
-        bool terminate = false;
-        bool resetting = false;
+        // bumped by update_thread() to wake the worker
+        std::atomic<uint64_t> run_epoch {0};
+        // bumped by reset_metrics(), applied by whoever takes mtx next
+        std::atomic<uint64_t> reset_epoch {0};
+        uint64_t applied_reset_epoch = 0;
+        std::atomic<bool> terminate {false};
         size_t max_size = 10000;
+        // only touched by the worker once it runs
         std::vector<metric_t> metrics;
+        // last calculated metrics, readable without mtx
+        std::atomic<std::shared_ptr<const std::vector<metric_t>>> snapshot;
 
         void _thread() {
-            thread_init = true;
+            uint64_t seen = 0;
             while (true){
-                std::unique_lock<std::mutex> lock(mtx);
-                cv.wait(lock, [this] { return run; });
+                run_epoch.wait(seen);
+                seen = run_epoch.load();
 
                 if (terminate)
                     break;
 
-                calculate();
-
-                run = false;
+                // The copy reuses scratch's buckets, so update() only ever
+                // waits for a memcpy
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    apply_reset();
+                    scratch = sketch;
+                }
+                calculate(scratch, metrics);
+                snapshot.store(std::make_shared<const std::vector<metric_t>>(metrics));
             }
         }
 
-        void calculate(){
-            if (frametimes.empty())
-                return; 
-
-            std::vector<float> sorted_values = frametimes;
-            std::sort(sorted_values.begin(), sorted_values.end(), std::greater<float>());
+        // mtx must be held
+        void apply_reset() {
+            auto epoch = reset_epoch.load(std::memory_order_acquire);
+            if (epoch == applied_reset_epoch)
+                return;
 
-            auto it = metrics.begin();
-            while (it != metrics.end()) {
-                if (it->name == "AVG") {
-                    it->display_name = it->name;
+            frametimes.clear();
+            frametimes_head = 0;
+            sketch.clear();
+            applied_reset_epoch = epoch;
+        }
 
-                    float sum = 0.0f;
-                    for (const auto& f : sorted_values)
-                        sum += f;
+        static void calculate(const quantile_sketch& frametimes, std::vector<metric_t>& out){
+            if (frametimes.count() == 0)
+                return;
 
-                    float avg = 1000.f / (sum / sorted_values.size());
-                    it->value = avg;
-                } else {
-                    try {
-                        float val = std::stof(it->name);
-                        if (val <= 0.0f || val >= 1.0f) {
-                            SPDLOG_DEBUG("Failed to use fps metric, it's out of range {}", it->name);
-                            it = metrics.erase(it);
-                            continue;
-                        }
-
-                        // Format display name as a percentage
-                        float multiplied_val = val * 100;
-                        std::ostringstream stream;
-                        stream << std::fixed << std::setprecision(multiplied_val == static_cast<int>(multiplied_val) ? 0 : 1)
-                               << multiplied_val << "%";
-                        it->display_name = stream.str();
-                        uint64_t idx = val * sorted_values.size() - 1;
-                        if (idx >= sorted_values.size())
-                            break;
-
-                        it->value = 1000.f / sorted_values[idx];
-                    } catch (const std::invalid_argument& e) {
-                        SPDLOG_DEBUG("Failed to use fps metric value {}", it->name);
-                        it = metrics.erase(it);
-                        continue;
-                    }
+            for (auto& metric : out) {
+                if (metric.name == "AVG") {
+                    metric.value = 1000.f / frametimes.mean();
+                    continue;
                 }
-                ++it;
+
+                uint64_t idx = metric.fraction * frametimes.count() - 1;
+                if (idx >= frametimes.count())
+                    break;
+
+                metric.value = 1000.f / frametimes.at_rank_desc(idx);
             }
         }
 
@@ -100,7 +102,29 @@ class fpsMetrics {
                 for(char& c : val) {
                     c = std::toupper(static_cast<unsigned char>(c));
                 }
-                _metrics.push_back({val, 0.0f});
+
+                metric_t metric {val, 0.0f, val};
+                if (val != "AVG") {
+                    try {
+                        metric.fraction = std::stof(val);
+                    } catch (const std::invalid_argument& e) {
+                        SPDLOG_DEBUG("Failed to use fps metric value {}", val);
+                        continue;
+                    }
+
+                    if (metric.fraction <= 0.0f || metric.fraction >= 1.0f) {
+                        SPDLOG_DEBUG("Failed to use fps metric, it's out of range {}", val);
+                        continue;
+                    }
+
+                    // Format display name as a percentage
+                    float multiplied_val = metric.fraction * 100;
+                    std::ostringstream stream;
+                    stream << std::fixed << std::setprecision(multiplied_val == static_cast<int>(multiplied_val) ? 0 : 1)
+                           << multiplied_val << "%";
+                    metric.display_name = stream.str();
+                }
+                _metrics.push_back(metric);
             }
             return _metrics;
         }
@@ -108,68 +132,57 @@ class fpsMetrics {
     public:
         fpsMetrics(std::vector<std::string> values){
             metrics = add_metrics_to_vector(values);
+            frametimes.reserve(max_size);
+            snapshot.store(std::make_shared<const std::vector<metric_t>>(metrics));
 
-            if (!thread_init) {
-                thread = std::thread(&fpsMetrics::_thread, this);
-                // "mangohud-fpsmetrics" wouldn't fit in the 15 byte limit
-                pthread_setname_np(thread.native_handle(), "mangohud-fpsmet");
-            }
+            thread = std::thread(&fpsMetrics::_thread, this);
+            // "mangohud-fpsmetrics" wouldn't fit in the 15 byte limit
+            pthread_setname_np(thread.native_handle(), "mangohud-fpsmet");
         };
 
-        fpsMetrics(std::vector<std::string> values, std::vector<float> only_frametime) {
+        fpsMetrics(std::vector<std::string> values, const quantile_sketch& frametime_sketch)
+            : sketch(frametime_sketch) {
             metrics = add_metrics_to_vector(values);
-            for (auto& frametime : only_frametime)
-                frametimes.push_back(frametime);
-
-            calculate();
+            calculate(sketch, metrics);
+            snapshot.store(std::make_shared<const std::vector<metric_t>>(metrics));
         };
 
         void update(float new_frametime) {
-            if (resetting)
-                return;
-
             if (new_frametime > 100000) return; // Ignore extremely long frames
 
             // lock before modifying vector
             std::lock_guard<std::mutex> lock(mtx);
-
-            if (frametimes.size() >= max_size)
-                frametimes.erase(frametimes.begin());
-
-            frametimes.push_back(new_frametime);
+            apply_reset();
+
+            if (frametimes.size() < max_size) {
+                frametimes.push_back(new_frametime);
+            } else {
+                sketch.remove(frametimes[frametimes_head]);
+                frametimes[frametimes_head] = new_frametime;
+                frametimes_head = (frametimes_head + 1) % max_size;
+            }
+            sketch.add(new_frametime);
         }
 
 
         void update_thread(){
-            if (resetting)
-                return;
-
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                run = true;
-            }
-            cv.notify_one();
+            run_epoch.fetch_add(1);
+            run_epoch.notify_one();
         }
 
+        // Never blocks, the frametimes are dropped on the next update() or
+        // calculation, whichever comes first
         void reset_metrics(){
-            resetting = true;
-            while (run){}
-            frametimes.clear();
-            resetting = false;
+            reset_epoch.fetch_add(1, std::memory_order_release);
         }
 
         std::vector<metric_t> copy_metrics() {
-            std::lock_guard<std::mutex> lock(mtx);
-            return metrics;
+            return *snapshot.load();
         }
 
         ~fpsMetrics(){
             terminate = true;
-            {
-                std::lock_guard<std::mutex> lock(mtx);
-                run = true;
-            }
-            cv.notify_one();
+            update_thread();
             if (thread.joinable())
                 thread.join();
         }
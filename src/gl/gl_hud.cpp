@@ -16,6 +16,7 @@
 #include "file_utils.h"
 #include "notify.h"
 #include "blacklist.h"
+#include "overhead.h"
 
 #include <glad/glad.h>
 
@@ -233,8 +234,12 @@ void imgui_render(gl_context *ctx, unsigned int width, unsigned int height)
         overlay_end_frame();
     }
 
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+        static const size_t draw_stage = g_overhead.stage("gl_draw");
+        ScopedOverhead timer(draw_stage);
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
     if (sw_stats.font_params_hash != params.font_params_hash)
     {
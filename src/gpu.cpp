@@ -72,7 +72,7 @@ GPUS::GPUS(const overlay_params* early_params) {
         }
 
         std::shared_ptr<GPU> ptr =
-            std::make_shared<GPU>(node_name, vendor_id, device_id, pci_dev, driver);
+            std::make_shared<GPU>(sampler, node_name, vendor_id, device_id, pci_dev, driver);
 
         if (params->gpu_list.size() == 1 && params->gpu_list[0] == idx++)
             ptr->is_active = true;
@@ -16,14 +16,15 @@
 #include "nvidia.h"
 #include "gpu_metrics_util.h"
 #include "gpu_fdinfo.h"
+#include "gpu_sampler.h"
 
 class GPU {
     public:
         gpu_metrics metrics;
         std::string drm_node;
-        std::unique_ptr<NVIDIA> nvidia = nullptr;
-        std::unique_ptr<AMDGPU> amdgpu = nullptr;
-        std::unique_ptr<GPU_fdinfo> fdinfo = nullptr;
+        std::shared_ptr<NVIDIA> nvidia = nullptr;
+        std::shared_ptr<AMDGPU> amdgpu = nullptr;
+        std::shared_ptr<GPU_fdinfo> fdinfo = nullptr;
         bool is_active = false;
         std::string pci_dev;
         uint32_t vendor_id = 0;
@@ -31,38 +32,51 @@ class GPU {
         const std::string driver;
 
         GPU(
-            std::string drm_node, uint32_t vendor_id, uint32_t device_id, const char* pci_dev,
-            std::string driver
+            GpuSampler& sampler, std::string drm_node, uint32_t vendor_id, uint32_t device_id,
+            const char* pci_dev, std::string driver
         )
             : drm_node(drm_node), pci_dev(pci_dev), vendor_id(vendor_id), device_id(device_id),
-            driver(driver) {
-                if (vendor_id == 0x10de)
-                    nvidia = std::make_unique<NVIDIA>(pci_dev);
+            driver(driver), sampler(sampler) {
+                if (vendor_id == 0x10de) {
+                    nvidia = std::make_shared<NVIDIA>(pci_dev);
+                    if (nvidia->nvml_available || nvidia->nvctrl_available)
+                        channel = sampler.add(nvidia);
+                }
 
-                if (vendor_id == 0x1002)
-                    amdgpu = std::make_unique<AMDGPU>(pci_dev, device_id, vendor_id, drm_node);
+                if (vendor_id == 0x1002) {
+                    amdgpu = std::make_shared<AMDGPU>(pci_dev, device_id, vendor_id, drm_node);
+                    channel = sampler.add(amdgpu);
+                }
 
                 if (
                     driver == "i915" || driver == "xe" ||
                     driver == "panfrost" || driver == "panthor" ||
                     driver == "msm_dpu" || driver == "msm_drm"
-                )
-                    fdinfo = std::make_unique<GPU_fdinfo>(driver, pci_dev, drm_node, device_id, vendor_id);
+                ) {
+                    fdinfo = std::make_shared<GPU_fdinfo>(driver, pci_dev, drm_node, device_id, vendor_id);
+                    channel = sampler.add(fdinfo);
+                }
         }
 
-        gpu_metrics get_metrics() {
-            if (nvidia)
-                this->metrics = nvidia->copy_metrics();
-
-            if (amdgpu)
-                this->metrics = amdgpu->copy_metrics();
+        ~GPU() {
+            if (channel)
+                sampler.remove(channel);
+        }
 
-            if (fdinfo)
-                this->metrics = fdinfo->copy_metrics();
+        gpu_metrics get_metrics() {
+            if (channel)
+                this->metrics = *channel->snapshot();
 
             return metrics;
         };
 
+        // Aggregates of a metric over a trailing window, zero without a backend
+        gpu_window_stats window_stats(gpu_window_field field, gpu_window window) {
+            if (channel)
+                return channel->window_stats(field, window);
+            return {};
+        }
+
         std::vector<int> nvidia_pids() {
 #ifdef HAVE_NVML
             if (nvidia)
@@ -72,25 +86,15 @@ class GPU {
         }
 
         void pause() {
-            if (nvidia)
-                nvidia->pause();
-
-            if (amdgpu)
-                amdgpu->pause();
-
-            if (fdinfo)
-                fdinfo->pause();
+            if (channel)
+                channel->paused = true;
         }
 
         void resume() {
-            if (nvidia)
-                nvidia->resume();
-
-            if (amdgpu)
-                amdgpu->resume();
-
-            if (fdinfo)
-                fdinfo->resume();
+            if (channel) {
+                channel->paused = false;
+                sampler.wake();
+            }
         }
 
         bool is_apu() {
@@ -114,13 +118,16 @@ class GPU {
         std::string vram_text();
 
     private:
-        std::thread thread;
+        GpuSampler& sampler;
+        std::shared_ptr<GpuChannel> channel;
 
         int index_in_selected_gpus();
 };
 
 class GPUS {
     public:
+        // one sampling thread for all GPUs, outlives them
+        GpuSampler sampler;
         std::vector<std::shared_ptr<GPU>> available_gpus;
         std::mutex mutex;
 
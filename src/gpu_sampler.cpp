@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "gpu_sampler.h"
+#ifndef TEST_ONLY
+#include "logging.h"
+#include "overlay_params.h"
+#endif
+
+using namespace std::chrono_literals;
+
+static float window_field(const gpu_metrics& m, gpu_window_field field) {
+    switch (field) {
+        case GPU_FIELD_LOAD: return m.load;
+        case GPU_FIELD_POWER: return m.powerUsage;
+        case GPU_FIELD_CORE_CLOCK: return m.CoreClock;
+        case GPU_FIELD_MEM_CLOCK: return m.MemClock;
+        case GPU_FIELD_TEMP: return m.temp;
+        case GPU_FIELD_JUNCTION_TEMP: return m.junction_temp;
+        case GPU_FIELD_MEMORY_TEMP: return m.memory_temp;
+        case GPU_FIELD_APU_CPU_POWER: return m.apu_cpu_power;
+        case GPU_FIELD_APU_CPU_TEMP: return m.apu_cpu_temp;
+        case GPU_FIELD_FAN_SPEED: return m.fan_speed;
+        case GPU_FIELD_POWER_THROTTLED: return m.is_power_throttled;
+        case GPU_FIELD_CURRENT_THROTTLED: return m.is_current_throttled;
+        case GPU_FIELD_TEMP_THROTTLED: return m.is_temp_throttled;
+        case GPU_FIELD_OTHER_THROTTLED: return m.is_other_throttled;
+        default: return 0.f;
+    }
+}
+
+// Histogram range of each field, the percentiles have range / 512 resolution
+static constexpr float window_range[GPU_FIELD_COUNT] = {
+    100.f,      // load
+    600.f,      // power
+    4000.f,     // core clock
+    16000.f,    // mem clock
+    128.f,      // temp
+    128.f,      // junction temp
+    128.f,      // memory temp
+    200.f,      // apu cpu power
+    128.f,      // apu cpu temp
+    5120.f,     // fan speed
+    1.f, 1.f, 1.f, 1.f, // throttling flags
+};
+
+gpu_window_stats GpuChannel::window_stats(gpu_window_field field, gpu_window window) {
+    std::lock_guard<std::mutex> lock(m_windows_mutex);
+    const rolling_window& w = m_windows[window][field];
+    return { w.last(), w.mean(), w.max(), w.percentile(0.95f) };
+}
+
+static constexpr unsigned window_ms[GPU_WINDOW_COUNT] = { 100, METRICS_UPDATE_PERIOD_MS, 1000 };
+// Room for a sample every 10ms at least, for drivers that buffer their own
+static constexpr unsigned min_buffered_interval_ms = 10;
+
+static uint64_t window_time(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void GpuChannel::reset_windows(unsigned period_ms) {
+    std::lock_guard<std::mutex> lock(m_windows_mutex);
+    m_period_ms = period_ms;
+    unsigned interval_ms = std::min(period_ms, min_buffered_interval_ms);
+    for (size_t w = 0; w < GPU_WINDOW_COUNT; w++)
+        for (size_t f = 0; f < GPU_FIELD_COUNT; f++)
+            m_windows[w][f].reset(std::max(window_ms[w] / interval_ms, 1u), window_range[f]);
+}
+
+void GpuChannel::run(clock::time_point now) {
+    unsigned period_ms = std::clamp(m_source->sample_period_ms(), 1u, unsigned(METRICS_UPDATE_PERIOD_MS));
+    if (period_ms != m_period_ms)
+        reset_windows(period_ms);
+
+    if (now - m_last_update >= std::chrono::milliseconds(METRICS_UPDATE_PERIOD_MS)) {
+        m_last_update = now;
+        m_source->update(m_instant);
+    }
+    m_source->sample(m_instant);
+    m_batch.clear();
+    m_source->take_samples(m_batch);
+
+    gpu_metrics out = m_instant;
+    {
+        std::lock_guard<std::mutex> lock(m_windows_mutex);
+        for (const auto& sample : m_batch.samples)
+            for (size_t w = 0; w < GPU_WINDOW_COUNT; w++)
+                m_windows[w][sample.field].push(sample.value, window_time(std::min(sample.time, now)));
+
+        uint64_t now_ns = window_time(now);
+        for (size_t f = 0; f < GPU_FIELD_COUNT; f++) {
+            bool buffered = m_batch.fields & (1u << f);
+            for (size_t w = 0; w < GPU_WINDOW_COUNT; w++) {
+                if (!buffered)
+                    m_windows[w][f].push(window_field(m_instant, gpu_window_field(f)), now_ns);
+                m_windows[w][f].expire(now_ns, window_ms[w] * 1000000ull);
+            }
+        }
+
+        const auto& hud = m_windows[GPU_WINDOW_HUD];
+        out.load = hud[GPU_FIELD_LOAD].mean();
+        out.powerUsage = hud[GPU_FIELD_POWER].mean();
+        out.CoreClock = hud[GPU_FIELD_CORE_CLOCK].mean();
+        out.MemClock = hud[GPU_FIELD_MEM_CLOCK].mean();
+        out.temp = hud[GPU_FIELD_TEMP].mean();
+        out.junction_temp = hud[GPU_FIELD_JUNCTION_TEMP].mean();
+        out.memory_temp = hud[GPU_FIELD_MEMORY_TEMP].mean();
+        out.apu_cpu_power = hud[GPU_FIELD_APU_CPU_POWER].mean();
+        out.apu_cpu_temp = hud[GPU_FIELD_APU_CPU_TEMP].mean();
+        out.fan_speed = hud[GPU_FIELD_FAN_SPEED].max();
+        out.is_power_throttled = hud[GPU_FIELD_POWER_THROTTLED].max() > 0;
+        out.is_current_throttled = hud[GPU_FIELD_CURRENT_THROTTLED].max() > 0;
+        out.is_temp_throttled = hud[GPU_FIELD_TEMP_THROTTLED].max() > 0;
+        out.is_other_throttled = hud[GPU_FIELD_OTHER_THROTTLED].max() > 0;
+    }
+    m_snapshot.store(std::make_shared<const gpu_metrics>(out));
+
+    // Keep the cadence, unless the sample took longer than a period
+    m_next_sample += std::chrono::milliseconds(period_ms);
+    if (m_next_sample < now)
+        m_next_sample = now + std::chrono::milliseconds(period_ms);
+}
+
+GpuSampler::~GpuSampler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+std::shared_ptr<GpuChannel> GpuSampler::add(std::shared_ptr<GpuSource> source) {
+    auto channel = std::make_shared<GpuChannel>(std::move(source));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_channels.push_back(channel);
+        m_generation++;
+        m_changed = true;
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&GpuSampler::run, this);
+            pthread_setname_np(m_thread.native_handle(), "mangohud-gpu");
+        }
+    }
+    m_cv.notify_one();
+    return channel;
+}
+
+void GpuSampler::remove(const std::shared_ptr<GpuChannel>& channel) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::erase(m_channels, channel);
+        m_generation++;
+        m_changed = true;
+    }
+    // so the thread lets go of its reference now rather than on its next pass
+    m_cv.notify_one();
+}
+
+void GpuSampler::wake() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changed = true;
+    }
+    m_cv.notify_one();
+}
+
+void GpuSampler::run() {
+    // Sources are sampled unlocked from this copy of m_channels, which is
+    // only redone after add() or remove(). A removed channel stays alive in
+    // it until the pass that notices.
+    std::vector<std::shared_ptr<GpuChannel>> channels;
+    uint64_t generation = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        auto now = GpuChannel::clock::now();
+        auto next = now + 1s;
+        m_changed = false;
+
+#ifndef TEST_ONLY
+        if (get_params()->no_display && !(logger && logger->is_active())) {
+            m_cv.wait_for(lock, 100ms, [this] { return m_stop; });
+            continue;
+        }
+#endif
+
+        if (generation != m_generation) {
+            channels.assign(m_channels.begin(), m_channels.end());
+            generation = m_generation;
+        }
+        lock.unlock();
+        for (auto& channel : channels) {
+            if (channel->paused)
+                continue;
+            if (now >= channel->m_next_sample)
+                channel->run(now);
+            next = std::min(next, channel->m_next_sample);
+        }
+        lock.lock();
+
+        m_cv.wait_until(lock, next, [this] { return m_stop || m_changed; });
+    }
+}
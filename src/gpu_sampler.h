@@ -0,0 +1,151 @@
+#pragma once
+#ifndef MANGOHUD_GPU_SAMPLER_H
+#define MANGOHUD_GPU_SAMPLER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gpu_metrics_util.h"
+#include "rolling_window.h"
+
+// Fields of gpu_metrics that are aggregated over a window. Everything else
+// (vram, limits, totals) is published as last read.
+enum gpu_window_field {
+    GPU_FIELD_LOAD,
+    GPU_FIELD_POWER,
+    GPU_FIELD_CORE_CLOCK,
+    GPU_FIELD_MEM_CLOCK,
+    GPU_FIELD_TEMP,
+    GPU_FIELD_JUNCTION_TEMP,
+    GPU_FIELD_MEMORY_TEMP,
+    GPU_FIELD_APU_CPU_POWER,
+    GPU_FIELD_APU_CPU_TEMP,
+    GPU_FIELD_FAN_SPEED,
+    GPU_FIELD_POWER_THROTTLED,
+    GPU_FIELD_CURRENT_THROTTLED,
+    GPU_FIELD_TEMP_THROTTLED,
+    GPU_FIELD_OTHER_THROTTLED,
+    GPU_FIELD_COUNT
+};
+
+enum gpu_window {
+    GPU_WINDOW_100MS,
+    GPU_WINDOW_HUD, // METRICS_UPDATE_PERIOD_MS, what get_metrics() reports
+    GPU_WINDOW_1S,
+    GPU_WINDOW_COUNT
+};
+
+struct gpu_window_stats {
+    float last; // the most recent sample
+    float mean;
+    float max;
+    float p95;
+};
+
+// Readings a driver took on its own between two sample() calls, each with
+// the time it was taken at
+struct gpu_sample_batch {
+    struct entry {
+        gpu_window_field field;
+        std::chrono::steady_clock::time_point time;
+        float value;
+    };
+
+    // fields whose windows get these samples instead of gpu_metrics' value
+    uint32_t fields = 0;
+    std::vector<entry> samples;
+
+    void add(gpu_window_field field, std::chrono::steady_clock::time_point time, float value) {
+        fields |= 1u << field;
+        samples.push_back({field, time, value});
+    }
+    void clear() { fields = 0; samples.clear(); }
+};
+
+// A vendor backend. All of its methods run on the sampler thread.
+class GpuSource {
+public:
+    virtual ~GpuSource() = default;
+
+    // Interval between two sample() calls
+    virtual unsigned sample_period_ms() const { return METRICS_UPDATE_PERIOD_MS; }
+    // Reads the fast changing fields into `metrics`. It is the same struct
+    // every time, fields that aren't touched keep their last value.
+    virtual void sample(gpu_metrics& metrics) = 0;
+    // Slow or rarely changing fields, once per METRICS_UPDATE_PERIOD_MS
+    // and right before a sample() so that it can override them
+    virtual void update(gpu_metrics& metrics) { (void)metrics; }
+    // Called after every sample(). Sources whose driver keeps its own
+    // sample buffer hand the individual readings over here, so the windows
+    // see them rather than one value per sample_period_ms().
+    virtual void take_samples(gpu_sample_batch& batch) { (void)batch; }
+};
+
+// One GPU as registered with the sampler
+class GpuChannel {
+public:
+    explicit GpuChannel(std::shared_ptr<GpuSource> source) : m_source(std::move(source)) {}
+
+    // Latest published metrics, never blocks on the sampler
+    std::shared_ptr<const gpu_metrics> snapshot() const { return m_snapshot.load(); }
+    gpu_window_stats window_stats(gpu_window_field field, gpu_window window);
+
+    std::atomic<bool> paused {false};
+
+private:
+    friend class GpuSampler;
+    using clock = std::chrono::steady_clock;
+
+    void run(clock::time_point now);
+    void reset_windows(unsigned period_ms);
+
+    std::shared_ptr<GpuSource> m_source;
+    std::atomic<std::shared_ptr<const gpu_metrics>> m_snapshot {std::make_shared<const gpu_metrics>()};
+
+    // sampler thread only
+    gpu_metrics m_instant;
+    gpu_sample_batch m_batch;
+    unsigned m_period_ms = 0;
+    clock::time_point m_next_sample {};
+    clock::time_point m_last_update {};
+
+    std::mutex m_windows_mutex;
+    rolling_window m_windows[GPU_WINDOW_COUNT][GPU_FIELD_COUNT];
+};
+
+// Drives every GpuSource from one thread. Each source is sampled at its
+// own period, and every vendor gets the same rolling windows: means of
+// load, power, clocks and temperatures over the HUD window, the max of the
+// fan speed and of each throttling flag. The windows span 100ms, the HUD
+// period and 1s of sample time, however many samples a source fed them.
+class GpuSampler {
+public:
+    GpuSampler() = default;
+    ~GpuSampler();
+    GpuSampler(const GpuSampler&) = delete;
+    GpuSampler& operator=(const GpuSampler&) = delete;
+
+    std::shared_ptr<GpuChannel> add(std::shared_ptr<GpuSource> source);
+    void remove(const std::shared_ptr<GpuChannel>& channel);
+    // Wakes the thread after a channel is resumed
+    void wake();
+
+private:
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<std::shared_ptr<GpuChannel>> m_channels;
+    // bumped whenever m_channels changes
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+    bool m_changed = false;
+    std::thread m_thread;
+};
+
+#endif //MANGOHUD_GPU_SAMPLER_H
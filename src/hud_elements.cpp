@@ -4,6 +4,7 @@
 #include <sstream>
 #include <cmath>
 #include <map>
+#include <span>
 #include "overlay.h"
 #include "overlay_params.h"
 #include "hud_elements.h"
@@ -29,6 +30,9 @@
 #include "ftrace.h"
 #include "winesync.h"
 #include "fps_limiter.h"
+#include "overhead.h"
+#include "pressure.h"
+#include "thread_stats.h"
 
 #define CHAR_CELSIUS    "\xe2\x84\x83"
 #define CHAR_FAHRENHEIT "\xe2\x84\x89"
@@ -390,11 +394,15 @@ void HudElements::gpu_stats(){
                 ImguiNextColumnOrNewRow();
                 float efficiency;
                 const char* efficiency_unit;
+                // Measured energy per frame when the GPU has it, else from the averaged power
+                float joules_per_frame = HUDElements.sw_stats->gpu_joules_per_frame;
+                if (joules_per_frame <= 0.f)
+                    joules_per_frame = gpu->metrics.powerUsage/HUDElements.sw_stats->fps;
                 if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_flip_efficiency]) {
-                    efficiency=gpu->metrics.powerUsage/HUDElements.sw_stats->fps;
+                    efficiency=joules_per_frame;
                     efficiency_unit="J/F";
                 } else {
-                    efficiency=HUDElements.sw_stats->fps/gpu->metrics.powerUsage;
+                    efficiency=1.f/joules_per_frame;
                     efficiency_unit="F/J";
                 }
                 right_aligned_text(text_color, HUDElements.ralign_width, "%.2f", efficiency);
@@ -431,7 +439,7 @@ void HudElements::cpu_stats(){
         ImguiNextColumnOrNewRow();
         auto text_color = HUDElements.colors.text;
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_load_change]){
-            int cpu_load_percent = int(cpuStats.GetCPUDataTotal().percent);
+            int cpu_load_percent = int(HUDElements.hw->data.cpu_load);
             struct LOAD_DATA cpu_data = {
                 HUDElements.colors.cpu_load_low,
                 HUDElements.colors.cpu_load_med,
@@ -446,7 +454,7 @@ void HudElements::cpu_stats(){
             HUDElements.TextColored(load_color, "%%");
         }
         else {
-            right_aligned_text(text_color, HUDElements.ralign_width, "%d", int(cpuStats.GetCPUDataTotal().percent));
+            right_aligned_text(text_color, HUDElements.ralign_width, "%d", int(HUDElements.hw->data.cpu_load));
             ImGui::SameLine(0, 1.0f);
             HUDElements.TextColored(HUDElements.colors.text, "%%");
         }
@@ -454,9 +462,9 @@ void HudElements::cpu_stats(){
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_temp]){
             ImguiNextColumnOrNewRow();
             if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_temp_fahrenheit])
-                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.convert_to_fahrenheit(cpuStats.GetCPUDataTotal().temp));
+                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.convert_to_fahrenheit(HUDElements.hw->data.cpu_temp));
             else
-                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuStats.GetCPUDataTotal().temp);
+                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.hw->data.cpu_temp);
             ImGui::SameLine(0, 1.0f);
             if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_hud_compact])
                 HUDElements.TextColored(HUDElements.colors.text, "°");
@@ -469,7 +477,7 @@ void HudElements::cpu_stats(){
 
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_mhz]){
             ImguiNextColumnOrNewRow();
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuStats.GetCPUDataTotal().cpu_mhz);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", HUDElements.hw->data.cpu_mhz);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
             HUDElements.TextColored(HUDElements.colors.text, "MHz");
@@ -479,11 +487,11 @@ void HudElements::cpu_stats(){
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_cpu_power]){
             ImguiNextColumnOrNewRow();
             char str[16];
-            snprintf(str, sizeof(str), "%.1f", cpuStats.GetCPUDataTotal().power);
+            snprintf(str, sizeof(str), "%.1f", HUDElements.hw->data.cpu_power);
             if (strlen(str) > 4)
-                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", cpuStats.GetCPUDataTotal().power);
+                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", HUDElements.hw->data.cpu_power);
             else
-                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", cpuStats.GetCPUDataTotal().power);
+                right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", HUDElements.hw->data.cpu_power);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
             HUDElements.TextColored(HUDElements.colors.text, "W");
@@ -495,10 +503,10 @@ void HudElements::cpu_stats(){
             float efficiency;
             const char* efficiency_unit;
             if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_flip_efficiency]) {
-                efficiency=cpuStats.GetCPUDataTotal().power/HUDElements.sw_stats->fps;
+                efficiency=HUDElements.hw->data.cpu_power/HUDElements.sw_stats->fps;
                 efficiency_unit="J/F";
             } else {
-                efficiency=HUDElements.sw_stats->fps/cpuStats.GetCPUDataTotal().power;
+                efficiency=HUDElements.sw_stats->fps/HUDElements.hw->data.cpu_power;
                 efficiency_unit="F/J";
             }
             right_aligned_text(text_color, HUDElements.ralign_width, "%.2f", efficiency);
@@ -511,11 +519,6 @@ void HudElements::cpu_stats(){
 }
 
 
-static float get_core_load_stat(void*,int);
-static float get_core_load_stat(void *data, int idx){
-    return ((CPUStats *)data)->GetCPUData().at(idx).percent;
-}
-
 void HudElements::core_load(){
     if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_load])
         return;
@@ -543,8 +546,9 @@ void HudElements::core_load(){
         }
 
         if (ImGui::BeginChild("core_bars_window", ImVec2(width, height))) {
-            ImGui::PlotHistogram(hash, get_core_load_stat, &cpuStats,
-                                cpuStats.GetCPUData().size(), 0,
+            auto& loads = HUDElements.hw->core_load;
+            ImGui::PlotHistogram(hash, loads.data(),
+                                int(loads.size()), 0,
                                 NULL, 0.0, 100.0,
                                 ImVec2(width, height));
         }
@@ -552,23 +556,28 @@ void HudElements::core_load(){
         ImGui::PopFont();
         ImGui::PopStyleColor();
     } else {
-        for (const CPUData &cpuData : cpuStats.GetCPUData())
+        auto& loads = HUDElements.hw->core_load;
+        auto& mhz = HUDElements.hw->core_mhz;
+        auto& ids = HUDElements.hw->core_id;
+        auto& labels = HUDElements.hw->core_label;
+        for (size_t i = 0; i < ids.size(); i++)
         {
+            float load = i < loads.size() ? loads[i] : 0.f;
             ImguiNextColumnFirstItem();
             HUDElements.TextColored(HUDElements.colors.cpu, "CPU");
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
 
             if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_type])
-                HUDElements.TextColored(HUDElements.colors.cpu, cpuData.label.c_str());
+                HUDElements.TextColored(HUDElements.colors.cpu, labels[i].c_str());
             else
-                HUDElements.TextColored(HUDElements.colors.cpu, "%i", cpuData.cpu_id);
+                HUDElements.TextColored(HUDElements.colors.cpu, "%i", ids[i]);
 
             ImGui::PopFont();
             ImguiNextColumnOrNewRow();
             auto text_color = HUDElements.colors.text;
             if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_core_load_change]){
-                int cpu_load_percent = int(cpuData.percent);
+                int cpu_load_percent = int(load);
                 struct LOAD_DATA cpu_data = {
                     HUDElements.colors.cpu_load_low,
                     HUDElements.colors.cpu_load_med,
@@ -583,12 +592,12 @@ void HudElements::core_load(){
                 ImguiNextColumnOrNewRow();
             }
             else {
-                right_aligned_text(text_color, HUDElements.ralign_width, "%i", int(cpuData.percent));
+                right_aligned_text(text_color, HUDElements.ralign_width, "%i", int(load));
                 ImGui::SameLine(0, 1.0f);
                 HUDElements.TextColored(HUDElements.colors.text, "%%");
                 ImguiNextColumnOrNewRow();
             }
-            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", cpuData.mhz);
+            right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%i", i < mhz.size() ? mhz[i] : 0);
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
             HUDElements.TextColored(HUDElements.colors.text, "MHz");
@@ -610,7 +619,7 @@ void HudElements::io_stats(){
 
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_io_read]){
             ImguiNextColumnOrNewRow();
-            const float val = g_io_stats.per_second.read;
+            const float val = HUDElements.hw->io_read;
             right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, val < 100 ? "%.1f" : "%.f", val);
             ImGui::SameLine(0,1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
@@ -619,7 +628,7 @@ void HudElements::io_stats(){
         }
         if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_io_write]){
             ImguiNextColumnOrNewRow();
-            const float val = g_io_stats.per_second.write;
+            const float val = HUDElements.hw->io_write;
             right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, val < 100 ? "%.1f" : "%.f", val);
             ImGui::SameLine(0,1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
@@ -760,7 +769,7 @@ void HudElements::ram(){
 
     if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_ram]) {
         ImguiNextColumnOrNewRow();
-        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", memused);
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", HUDElements.hw->data.ram_used);
         if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_hud_compact]){
             ImGui::SameLine(0, 1.0f);
             ImGui::PushFont(HUDElements.sw_stats->font_small);
@@ -771,7 +780,7 @@ void HudElements::ram(){
 
     if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_ram] && HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_swap]){
         ImguiNextColumnOrNewRow();
-        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", swapused);
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", HUDElements.hw->data.swap_used);
         ImGui::SameLine(0, 1.0f);
         ImGui::PushFont(HUDElements.sw_stats->font_small);
         HUDElements.TextColored(HUDElements.colors.text, "GiB");
@@ -806,7 +815,7 @@ void HudElements::procmem()
     ImguiNextColumnFirstItem();
     HUDElements.TextColored(HUDElements.colors.ram, "PMEM");
     ImguiNextColumnOrNewRow();
-    right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(proc_mem_resident, unit));
+    right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(HUDElements.hw->proc_mem_resident, unit));
     ImGui::SameLine(0, 1.0f);
     ImGui::PushFont(HUDElements.sw_stats->font_small);
     HUDElements.TextColored(HUDElements.colors.text, "%s", unit);
@@ -814,7 +823,7 @@ void HudElements::procmem()
 
     if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_procmem_shared]) {
         ImguiNextColumnOrNewRow();
-        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(proc_mem_shared, unit));
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(HUDElements.hw->proc_mem_shared, unit));
         ImGui::SameLine(0,1.0f);
         ImGui::PushFont(HUDElements.sw_stats->font_small);
         HUDElements.TextColored(HUDElements.colors.text, "%s", unit);
@@ -823,7 +832,7 @@ void HudElements::procmem()
 
     if (HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_procmem_virt]) {
         ImguiNextColumnOrNewRow();
-        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(proc_mem_virt, unit));
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.1f", format_units(HUDElements.hw->proc_mem_virt, unit));
         ImGui::SameLine(0, 1.0f);
         ImGui::PushFont(HUDElements.sw_stats->font_small);
         HUDElements.TextColored(HUDElements.colors.text, "%s", unit);
@@ -1518,7 +1527,7 @@ void HudElements::graphs(){
     ImguiNextColumnFirstItem();
     ImGui::Dummy(ImVec2(0.0f, real_font_size.y));
     const std::string& value = HUDElements.ordered_functions[HUDElements.place].value;
-    assert(kMaxGraphEntries >= graph_data.size());
+    std::span<const logData> graph_data(HUDElements.hw->history.data(), HUDElements.hw->history_size);
     std::vector<float> arr(kMaxGraphEntries - graph_data.size());
 
     ImGui::PushFont(HUDElements.sw_stats->font_small);
@@ -1608,10 +1617,21 @@ void HudElements::graphs(){
             arr.push_back(float(it.ram_used));
         }
 
-        HUDElements.max = memmax;
+        HUDElements.max = get_meminfo()->total();
         HUDElements.min = 0;
         HUDElements.TextColored(HUDElements.colors.engine, "%s", "RAM");
     }
+
+    if (value == "psi_cpu" || value == "psi_memory" || value == "psi_io"){
+        for (auto& it : graph_data){
+            arr.push_back(value == "psi_cpu" ? it.psi_cpu : value == "psi_memory" ? it.psi_memory : it.psi_io);
+        }
+
+        HUDElements.max = 100;
+        HUDElements.min = 0;
+        HUDElements.TextColored(HUDElements.colors.engine, "%s",
+            value == "psi_cpu" ? "CPU Pressure" : value == "psi_memory" ? "Mem Pressure" : "IO Pressure");
+    }
 #endif
     ImGui::PopFont();
     ImGui::Dummy(ImVec2(0.0f,5.0f));
@@ -1727,13 +1747,7 @@ void HudElements::present_mode() {
 
 void HudElements::network() {
 #ifdef __linux__
-    if (HUDElements.net && HUDElements.net->should_reset)
-        HUDElements.net.reset(new Net);
-
-    if (!HUDElements.net)
-        HUDElements.net = std::make_unique<Net>();
-
-    for (auto& iface : HUDElements.net->interfaces){
+    for (auto& iface : HUDElements.hw->net){
         ImguiNextColumnFirstItem();
         HUDElements.TextColored(HUDElements.colors.network, "%.8s", iface.name.c_str());
         ImguiNextColumnOrNewRow();
@@ -1752,6 +1766,101 @@ void HudElements::network() {
 #endif
 }
 
+void HudElements::mangohud_overhead() {
+    ImguiNextColumnFirstItem();
+    HUDElements.TextColored(HUDElements.colors.engine, "%s", "MangoHud");
+    ImguiNextColumnOrNewRow();
+    right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.2f", g_overhead.total_load());
+    ImGui::SameLine(0, 1.0f);
+    ImGui::PushFont(HUDElements.sw_stats->font_small);
+    HUDElements.TextColored(HUDElements.colors.text, "%%");
+    ImGui::PopFont();
+
+    auto summary = g_overhead.summary();
+    if (!summary)
+        return;
+
+    ImGui::PushFont(HUDElements.sw_stats->font_secondary);
+    for (auto& stage : *summary) {
+        if (stage.calls == 0)
+            continue;
+
+        if (!HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_horizontal])
+            ImGui::TableNextRow();
+        ImguiNextColumnFirstItem();
+        HUDElements.TextColored(HUDElements.colors.text, "%s", stage.name.c_str());
+        ImguiNextColumnOrNewRow();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", stage.avg_us);
+        ImGui::SameLine(0, 1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font_small);
+        HUDElements.TextColored(HUDElements.colors.text, "us");
+        ImGui::PopFont();
+        ImguiNextColumnOrNewRow();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", stage.p99_us);
+        ImGui::SameLine(0, 1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font_small);
+        HUDElements.TextColored(HUDElements.colors.text, "p99");
+        ImGui::PopFont();
+    }
+    ImGui::PopFont();
+}
+
+void HudElements::pressure() {
+#ifdef __linux__
+    if (!HUDElements.hw->psi_valid)
+        return;
+
+    static const std::pair<const char*, pressure_resource> rows[] = {
+        {"PSI CPU", PRESSURE_CPU}, {"PSI MEM", PRESSURE_MEMORY}, {"PSI IO", PRESSURE_IO},
+    };
+
+    for (auto& [label, resource] : rows) {
+        auto& stats = HUDElements.hw->psi[resource];
+        // highlight while a stall spike is recent
+        auto color = stats.stalling ? HUDElements.colors.fps_value_low : HUDElements.colors.text;
+
+        if (resource != PRESSURE_CPU && !HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_horizontal])
+            ImGui::TableNextRow();
+        ImguiNextColumnFirstItem();
+        HUDElements.TextColored(HUDElements.colors.engine, "%s", label);
+        ImguiNextColumnOrNewRow();
+        right_aligned_text(color, HUDElements.ralign_width, "%.1f", stats.some);
+        ImGui::SameLine(0, 1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font_small);
+        HUDElements.TextColored(HUDElements.colors.text, "%%");
+        ImGui::PopFont();
+        ImguiNextColumnOrNewRow();
+        right_aligned_text(color, HUDElements.ralign_width, "%.1f", stats.full);
+        ImGui::SameLine(0, 1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font_small);
+        HUDElements.TextColored(HUDElements.colors.text, "full");
+        ImGui::PopFont();
+    }
+#endif
+}
+
+void HudElements::thread_load() {
+#ifdef __linux__
+    auto& threads = HUDElements.hw->threads;
+    size_t count = HUDElements.hw->thread_count;
+
+    ImGui::PushFont(HUDElements.sw_stats->font_secondary);
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && !HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_horizontal])
+            ImGui::TableNextRow();
+        ImguiNextColumnFirstItem();
+        HUDElements.TextColored(HUDElements.colors.cpu, "%.15s", threads[i].name);
+        ImguiNextColumnOrNewRow();
+        right_aligned_text(HUDElements.colors.text, HUDElements.ralign_width, "%.0f", threads[i].load);
+        ImGui::SameLine(0, 1.0f);
+        ImGui::PushFont(HUDElements.sw_stats->font_small);
+        HUDElements.TextColored(HUDElements.colors.text, "%%");
+        ImGui::PopFont();
+    }
+    ImGui::PopFont();
+#endif
+}
+
 void HudElements::_display_session() {
     if (not HUDElements.params->enabled[OVERLAY_PARAM_ENABLED_display_server])
         return;
@@ -2001,6 +2110,9 @@ void HudElements::sort_elements(const std::pair<std::string, std::string>& optio
         {"display_server", {_display_session}},
         {"fex_stats", {fex_stats}},
         {"ftrace", {ftrace}},
+        {"mangohud_overhead", {mangohud_overhead}},
+        {"pressure", {pressure}},
+        {"thread_load", {thread_load}},
     };
 
     auto check_param = display_params.find(param);
@@ -2076,6 +2188,12 @@ void HudElements::legacy_elements(const overlay_params* temp_params){
         ordered_functions.push_back({throttling_status, "throttling_status", value});
     if (temp_params->enabled[OVERLAY_PARAM_ENABLED_fps])
         ordered_functions.push_back({fps, "fps", value});
+    if (temp_params->enabled[OVERLAY_PARAM_ENABLED_mangohud_overhead])
+        ordered_functions.push_back({mangohud_overhead, "mangohud_overhead", value});
+    if (temp_params->enabled[OVERLAY_PARAM_ENABLED_pressure])
+        ordered_functions.push_back({pressure, "pressure", value});
+    if (temp_params->enabled[OVERLAY_PARAM_ENABLED_thread_load])
+        ordered_functions.push_back({thread_load, "thread_load", value});
     for (const auto& pair : options) {
         if (pair.first.find("graphs") != std::string::npos) {
             std::stringstream ss(pair.second);
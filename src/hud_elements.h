@@ -9,11 +9,14 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_enum_string_helper.h>
 #include <array>
+#include <atomic>
 #include "net.h"
 #include "overlay_params.h"
 #include "shell.h"
 #include "gpu.h"
 
+struct HwSnapshot;
+
 struct Function {
     std::function<void()> run;  // Using std::function instead of a raw function pointer for more flexibility
     std::string name;
@@ -23,6 +26,8 @@ struct Function {
 class HudElements{
     public:
         struct swapchain_stats *sw_stats;
+        // latest hw info, set at the start of every frame
+        const HwSnapshot* hw = nullptr;
         std::shared_ptr<overlay_params> params;
         struct exec_entry {
             int             pos;
@@ -44,10 +49,13 @@ class HudElements{
         std::vector<Function> ordered_functions;
         std::vector<float> gamescope_debug_latency {};
         std::vector<float> gamescope_debug_app {};
+        // latest values of the above, safe to read from other threads
+        std::atomic<float> gamescope_latency_ms {-1};
+        std::atomic<float> gamescope_app_frametime_ms {-1};
         int min, max, gpu_core_max, gpu_mem_max, cpu_temp_max, gpu_temp_max;
         const std::vector<std::string> permitted_params = {
             "gpu_load", "cpu_load", "gpu_core_clock", "gpu_mem_clock",
-            "vram", "ram", "cpu_temp", "gpu_temp"
+            "vram", "ram", "cpu_temp", "gpu_temp", "psi_cpu", "psi_memory", "psi_io"
         };
         std::vector<exec_entry> exec_list;
         std::chrono::steady_clock::time_point overlay_start = std::chrono::steady_clock::now();
@@ -64,7 +72,8 @@ class HudElements{
         };
 
         display_servers display_server = UNKNOWN;
-        std::unique_ptr<Net> net = nullptr;
+        // created by the hw info thread the first time it polls the network
+        std::atomic<std::shared_ptr<Net>> net;
 #ifdef __linux__
         std::unique_ptr<Shell> shell = nullptr;
 #endif
@@ -118,6 +127,9 @@ class HudElements{
         static void _display_session();
         static void fex_stats();
         static void ftrace();
+        static void mangohud_overhead();
+        static void pressure();
+        static void thread_load();
 
         void convert_colors(const struct overlay_params& params);
         void convert_colors(bool do_conv, const struct overlay_params& params);
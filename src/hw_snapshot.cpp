@@ -0,0 +1,24 @@
+#include <algorithm>
+#include "hw_snapshot.h"
+
+HwSnapshotPublisher g_hw_snapshot;
+
+void HwSnapshotPublisher::publish() {
+  m_staging.version++;
+
+  auto& history = m_staging.history;
+  if (m_staging.history_size == history.size())
+    std::move(history.begin() + 1, history.end(), history.begin());
+  else
+    m_staging.history_size++;
+  history[m_staging.history_size - 1] = m_staging.data;
+
+  // the vectors keep their capacity, so this only allocates until the core count settles
+  m_hud.back() = m_staging;
+  m_hud.publish();
+
+  auto& log = m_log.back();
+  log.data = m_staging.data;
+  log.extra = m_staging.log_extra;
+  m_log.publish();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef MANGOHUD_HW_SNAPSHOT_H
+#define MANGOHUD_HW_SNAPSHOT_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "net.h"
+#include "pressure.h"
+#include "thread_stats.h"
+#include "triple_buffer.h"
+
+static const int kMaxGraphEntries = 50;
+
+// Everything one round of hw info polling produced, as seen by the HUD
+struct HwSnapshot {
+  // incremented on every publish
+  uint64_t version;
+  logData data;
+  // values of the running log's optional columns
+  std::vector<double> log_extra;
+  // MiB/s
+  float io_read, io_write;
+  uint64_t proc_mem_resident, proc_mem_shared, proc_mem_virt;
+  // per core, in the order of CPUStats::GetCPUData()
+  std::vector<float> core_load;
+  std::vector<int> core_mhz;
+  std::vector<int> core_id;
+  std::vector<std::string> core_label;
+  // pressure stall percentages, stalling while a PSI trigger fired recently
+  struct pressure_row {
+    float some, full;
+    bool stalling;
+  };
+  bool psi_valid;
+  std::array<pressure_row, PRESSURE_COUNT> psi;
+  // busiest threads first
+  std::array<thread_load, ThreadStats::max_top> threads;
+  size_t thread_count;
+  std::vector<Net::throughputData> net;
+  // samples for the graphs, oldest first
+  std::array<logData, kMaxGraphEntries> history;
+  size_t history_size;
+};
+
+// Hands the hw info thread's results to the render and log threads. The
+// hw thread fills staging() and calls publish(); each consumer gets its
+// own triple buffer, so readers see a consistent set of values without
+// locks and without racing the next update.
+class HwSnapshotPublisher {
+public:
+  // hw info thread only
+  HwSnapshot& staging() { return m_staging; }
+  void publish();
+
+  // Render thread only, valid until its next call
+  const HwSnapshot& hud() { return m_hud.read(); }
+  // Single consumer: Logger::try_log(), which only lets one thread in at
+  // a time, from the log thread or the present thread with log_interval=0
+  const logSample& log_sample() { return m_log.read(); }
+
+private:
+  HwSnapshot m_staging {};
+  triple_buffer<HwSnapshot> m_hud;
+  triple_buffer<logSample> m_log;
+};
+
+extern HwSnapshotPublisher g_hw_snapshot;
+
+#endif //MANGOHUD_HW_SNAPSHOT_H
@@ -1,7 +1,8 @@
 #include "iostats.h"
 #include "string_utils.h"
-#include <fstream>
+#include "file_utils.h"
 #include "hud_elements.h"
+#include "process_tree.h"
 
 struct iostats g_io_stats;
 
@@ -12,28 +13,37 @@ void getIoStats(iostats& io) {
     io.prev.read_bytes  = io.curr.read_bytes;
     io.prev.write_bytes = io.curr.write_bytes;
 
-    std::string f = "/proc/";
-
-    {
-        auto gs_pid = HUDElements.g_gamescopePid;
-        f += gs_pid < 1 ? "self" : std::to_string(gs_pid);
-        f += "/io";
-    }
-
-    std::ifstream file(f);
-
-    if (!file.is_open()) {
-        SPDLOG_ERROR("can't open {}", f);
-        return;
-    }
-
-    for (std::string line; std::getline(file, line);) {
-        if (starts_with(line, "read_bytes:")) {
-            try_stoull(io.curr.read_bytes, line.substr(12));
+    g_process_tree.update(HUDElements.g_gamescopePid);
+
+    // Counters of exited processes disappear, so the tree totals are
+    // advanced by the per-process deltas instead of summed directly
+    for (auto& m : g_process_tree.members()) {
+        auto contents = m.io.read();
+        if (contents.empty())
+            continue;
+
+        uint64_t read_bytes = m.read_bytes, write_bytes = m.write_bytes;
+        while (!contents.empty()) {
+            auto line = next_line(contents);
+            auto sep = line.find(':');
+            if (sep == std::string_view::npos)
+                continue;
+
+            auto key = line.substr(0, sep);
+            auto val = line.substr(sep + 1);
+            if (key == "read_bytes")
+                scan_u64(val, read_bytes);
+            else if (key == "write_bytes")
+                scan_u64(val, write_bytes);
         }
-        else if (starts_with(line, "write_bytes:")) {
-            try_stoull(io.curr.write_bytes, line.substr(13));
+
+        if (m.io_valid) {
+            io.curr.read_bytes  += read_bytes - m.read_bytes;
+            io.curr.write_bytes += write_bytes - m.write_bytes;
         }
+        m.io_valid = true;
+        m.read_bytes = read_bytes;
+        m.write_bytes = write_bytes;
     }
 
     if (io.last_update.time_since_epoch().count()) {
@@ -0,0 +1,77 @@
+#include "loader_lz4.h"
+#include <spdlog/spdlog.h>
+
+liblz4_loader::liblz4_loader() : loaded_(false) {
+}
+
+liblz4_loader::~liblz4_loader() {
+  CleanUp(loaded_);
+}
+
+bool liblz4_loader::Load(const std::string& library_name) {
+  if (loaded_) {
+    return false;
+  }
+
+  library_ = dlopen(library_name.c_str(), RTLD_LAZY | RTLD_NODELETE);
+  if (!library_) {
+    SPDLOG_ERROR("Failed to open " MANGOHUD_ARCH " {}: {}", library_name, dlerror());
+    return false;
+  }
+
+  LZ4F_compressFrameBound =
+      reinterpret_cast<decltype(this->LZ4F_compressFrameBound)>(
+          dlsym(library_, "LZ4F_compressFrameBound"));
+  if (!LZ4F_compressFrameBound) {
+    CleanUp(true);
+    return false;
+  }
+
+  LZ4F_compressFrame =
+      reinterpret_cast<decltype(this->LZ4F_compressFrame)>(
+          dlsym(library_, "LZ4F_compressFrame"));
+  if (!LZ4F_compressFrame) {
+    CleanUp(true);
+    return false;
+  }
+
+  LZ4F_isError =
+      reinterpret_cast<decltype(this->LZ4F_isError)>(
+          dlsym(library_, "LZ4F_isError"));
+  if (!LZ4F_isError) {
+    CleanUp(true);
+    return false;
+  }
+
+  LZ4F_getErrorName =
+      reinterpret_cast<decltype(this->LZ4F_getErrorName)>(
+          dlsym(library_, "LZ4F_getErrorName"));
+  if (!LZ4F_getErrorName) {
+    CleanUp(true);
+    return false;
+  }
+
+  loaded_ = true;
+  return true;
+}
+
+void liblz4_loader::CleanUp(bool unload) {
+  if (unload) {
+    dlclose(library_);
+    library_ = NULL;
+  }
+
+  loaded_ = false;
+  LZ4F_compressFrameBound = NULL;
+  LZ4F_compressFrame = NULL;
+  LZ4F_isError = NULL;
+  LZ4F_getErrorName = NULL;
+}
+
+static std::shared_ptr<liblz4_loader> loader;
+std::shared_ptr<liblz4_loader> get_liblz4()
+{
+    if (!loader)
+        loader = std::make_shared<liblz4_loader>("liblz4.so.1");
+    return loader;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+
+#include <string>
+#include <dlfcn.h>
+
+// Mirrors LZ4F_preferences_t from lz4frame.h (stable since lz4 1.8),
+// so the headers aren't needed at build time
+struct lz4f_frame_info {
+  int blockSizeID;
+  int blockMode;
+  int contentChecksumFlag;
+  int frameType;
+  unsigned long long contentSize;
+  unsigned dictID;
+  int blockChecksumFlag;
+};
+
+struct lz4f_preferences {
+  lz4f_frame_info frameInfo;
+  int compressionLevel;
+  unsigned autoFlush;
+  unsigned favorDecSpeed;
+  unsigned reserved[3];
+};
+
+class liblz4_loader {
+ public:
+  liblz4_loader();
+  liblz4_loader(const std::string& library_name) { Load(library_name); }
+  ~liblz4_loader();
+
+  bool Load(const std::string& library_name);
+  bool IsLoaded() { return loaded_; }
+
+  size_t (*LZ4F_compressFrameBound)(size_t srcSize, const lz4f_preferences* prefs);
+  size_t (*LZ4F_compressFrame)(void* dstBuffer, size_t dstCapacity,
+                               const void* srcBuffer, size_t srcSize,
+                               const lz4f_preferences* prefs);
+  unsigned (*LZ4F_isError)(size_t code);
+  const char* (*LZ4F_getErrorName)(size_t code);
+
+ private:
+  void CleanUp(bool unload);
+
+  void* library_ = nullptr;
+  bool loaded_ = false;
+
+  // Disallow copy constructor and assignment operator.
+  liblz4_loader(const liblz4_loader&);
+  void operator=(const liblz4_loader&);
+};
+
+std::shared_ptr<liblz4_loader> get_liblz4();
@@ -278,6 +278,19 @@ bool libnvml_loader::Load(const std::string& library_name) {
     return false;
   }
 
+#if defined(LIBRARY_LOADER_NVML_H_DLOPEN)
+  nvmlDeviceGetSamples =
+      reinterpret_cast<decltype(this->nvmlDeviceGetSamples)>(
+          dlsym(library_, "nvmlDeviceGetSamples"));
+#endif
+#if defined(LIBRARY_LOADER_NVML_H_DT_NEEDED)
+  nvmlDeviceGetSamples = &::nvmlDeviceGetSamples;
+#endif
+  if (!nvmlDeviceGetSamples) {
+    CleanUp(true);
+    return false;
+  }
+
   loaded_ = true;
   return true;
 }
@@ -304,4 +317,5 @@ void libnvml_loader::CleanUp(bool unload) {
   nvmlUnitGetHandleByIndex = NULL;
   nvmlDeviceGetFanSpeed = NULL;
   nvmlDeviceGetGraphicsRunningProcesses = NULL;
+  nvmlDeviceGetSamples = NULL;
 }
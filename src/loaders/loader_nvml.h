@@ -45,6 +45,7 @@ class libnvml_loader {
   decltype(&::nvmlUnitGetHandleByIndex) nvmlUnitGetHandleByIndex;
   decltype(&::nvmlDeviceGetFanSpeed) nvmlDeviceGetFanSpeed;
   decltype(&::nvmlDeviceGetGraphicsRunningProcesses) nvmlDeviceGetGraphicsRunningProcesses;
+  decltype(&::nvmlDeviceGetSamples) nvmlDeviceGetSamples;
 
  private:
   void CleanUp(bool unload);
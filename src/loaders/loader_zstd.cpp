@@ -0,0 +1,95 @@
+#include "loader_zstd.h"
+#include <spdlog/spdlog.h>
+
+libzstd_loader::libzstd_loader() : loaded_(false) {
+}
+
+libzstd_loader::~libzstd_loader() {
+  CleanUp(loaded_);
+}
+
+bool libzstd_loader::Load(const std::string& library_name) {
+  if (loaded_) {
+    return false;
+  }
+
+  library_ = dlopen(library_name.c_str(), RTLD_LAZY | RTLD_NODELETE);
+  if (!library_) {
+    SPDLOG_ERROR("Failed to open " MANGOHUD_ARCH " {}: {}", library_name, dlerror());
+    return false;
+  }
+
+  ZSTD_compressBound =
+      reinterpret_cast<decltype(this->ZSTD_compressBound)>(
+          dlsym(library_, "ZSTD_compressBound"));
+  if (!ZSTD_compressBound) {
+    CleanUp(true);
+    return false;
+  }
+
+  ZSTD_createCCtx =
+      reinterpret_cast<decltype(this->ZSTD_createCCtx)>(
+          dlsym(library_, "ZSTD_createCCtx"));
+  if (!ZSTD_createCCtx) {
+    CleanUp(true);
+    return false;
+  }
+
+  ZSTD_freeCCtx =
+      reinterpret_cast<decltype(this->ZSTD_freeCCtx)>(
+          dlsym(library_, "ZSTD_freeCCtx"));
+  if (!ZSTD_freeCCtx) {
+    CleanUp(true);
+    return false;
+  }
+
+  ZSTD_compressCCtx =
+      reinterpret_cast<decltype(this->ZSTD_compressCCtx)>(
+          dlsym(library_, "ZSTD_compressCCtx"));
+  if (!ZSTD_compressCCtx) {
+    CleanUp(true);
+    return false;
+  }
+
+  ZSTD_isError =
+      reinterpret_cast<decltype(this->ZSTD_isError)>(
+          dlsym(library_, "ZSTD_isError"));
+  if (!ZSTD_isError) {
+    CleanUp(true);
+    return false;
+  }
+
+  ZSTD_getErrorName =
+      reinterpret_cast<decltype(this->ZSTD_getErrorName)>(
+          dlsym(library_, "ZSTD_getErrorName"));
+  if (!ZSTD_getErrorName) {
+    CleanUp(true);
+    return false;
+  }
+
+  loaded_ = true;
+  return true;
+}
+
+void libzstd_loader::CleanUp(bool unload) {
+  if (unload) {
+    dlclose(library_);
+    library_ = NULL;
+  }
+
+  loaded_ = false;
+  ZSTD_compressBound = NULL;
+  ZSTD_createCCtx = NULL;
+  ZSTD_freeCCtx = NULL;
+  ZSTD_compressCCtx = NULL;
+  ZSTD_isError = NULL;
+  ZSTD_getErrorName = NULL;
+}
+
+static std::shared_ptr<libzstd_loader> loader;
+std::shared_ptr<libzstd_loader> get_libzstd()
+{
+    if (!loader)
+        loader = std::make_shared<libzstd_loader>("libzstd.so.1");
+    return loader;
+}
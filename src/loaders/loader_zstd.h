@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <cstddef>
+
+#include <string>
+#include <dlfcn.h>
+
+// Only the parts of zstd.h used for log compression, so the headers aren't
+// needed at build time
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+
+class libzstd_loader {
+ public:
+  libzstd_loader();
+  libzstd_loader(const std::string& library_name) { Load(library_name); }
+  ~libzstd_loader();
+
+  bool Load(const std::string& library_name);
+  bool IsLoaded() { return loaded_; }
+
+  size_t (*ZSTD_compressBound)(size_t srcSize);
+  ZSTD_CCtx* (*ZSTD_createCCtx)(void);
+  size_t (*ZSTD_freeCCtx)(ZSTD_CCtx* cctx);
+  size_t (*ZSTD_compressCCtx)(ZSTD_CCtx* cctx, void* dst, size_t dstCapacity,
+                              const void* src, size_t srcSize, int compressionLevel);
+  unsigned (*ZSTD_isError)(size_t code);
+  const char* (*ZSTD_getErrorName)(size_t code);
+
+ private:
+  void CleanUp(bool unload);
+
+  void* library_ = nullptr;
+  bool loaded_ = false;
+
+  // Disallow copy constructor and assignment operator.
+  libzstd_loader(const libzstd_loader&);
+  void operator=(const libzstd_loader&);
+};
+
+std::shared_ptr<libzstd_loader> get_libzstd();
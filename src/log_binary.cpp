@@ -0,0 +1,82 @@
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include "log_binary.h"
+#include "logging.h"
+
+static const char file_magic[8] = {'M', 'H', 'L', 'O', 'G', 'B', 'I', 'N'};
+static const char block_magic[4] = {'B', 'L', 'K', '1'};
+
+template<typename T>
+static void write_raw(LogFile& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+void BinaryLogWriter::put(size_t column, T value) {
+  auto& buf = m_columns[column];
+  auto pos = buf.size();
+  buf.resize(pos + sizeof(value));
+  memcpy(buf.data() + pos, &value, sizeof(value));
+}
+
+void BinaryLogWriter::open(LogFile& file, const std::string& preamble,
+                           const std::vector<log_column>& columns) {
+  file.write(file_magic, sizeof(file_magic));
+  write_raw<uint32_t>(file, version);
+  write_raw<uint32_t>(file, columns.size());
+  write_raw<uint32_t>(file, preamble.size());
+  write_raw<uint32_t>(file, 0);
+  for (auto& col : columns) {
+    char name[column_name_size] {};
+    strncpy(name, col.name.c_str(), sizeof(name) - 1);
+    file.write(name, sizeof(name));
+    write_raw<uint8_t>(file, col.type);
+  }
+  file.write(preamble);
+
+  m_out = &file;
+  m_schema = columns;
+  m_columns.assign(columns.size(), {});
+  m_rows = 0;
+}
+
+void BinaryLogWriter::append(const logSample& sample) {
+  if (!m_out)
+    return;
+
+  for (size_t i = 0; i < m_schema.size(); i++) {
+    double value = m_schema[i].get(sample);
+    switch (m_schema[i].type) {
+      case LOG_COLUMN_F64: put<double>(i, value); break;
+      case LOG_COLUMN_F32: put<float>(i, value); break;
+      case LOG_COLUMN_I32: put<int32_t>(i, value); break;
+      case LOG_COLUMN_I64: put<int64_t>(i, value); break;
+    }
+  }
+
+  if (++m_rows >= rows_per_block)
+    flush();
+}
+
+void BinaryLogWriter::flush() {
+  if (!m_out || m_rows == 0)
+    return;
+
+  m_out->write(block_magic, sizeof(block_magic));
+  write_raw<uint32_t>(*m_out, m_rows);
+  for (auto& buf : m_columns) {
+    m_out->write(buf.data(), buf.size());
+    buf.clear();
+  }
+  m_rows = 0;
+}
+
+void BinaryLogWriter::close() {
+  if (!m_out)
+    return;
+
+  flush();
+  m_out = nullptr;
+  m_columns.clear();
+  m_schema.clear();
+}
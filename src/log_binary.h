@@ -0,0 +1,59 @@
+#pragma once
+#ifndef MANGOHUD_LOG_BINARY_H
+#define MANGOHUD_LOG_BINARY_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "log_schema.h"
+#include "log_file.h"
+
+/*
+ * Columnar binary log (log_format=binary)
+ *
+ * All integers are little-endian. The file starts with a fixed-width header:
+ *
+ *   char     magic[8]        "MHLOGBIN"
+ *   uint32_t version
+ *   uint32_t column_count
+ *   uint32_t preamble_size   size of the csv preamble that follows the columns
+ *   uint32_t reserved
+ *   struct { char name[31]; uint8_t type; } columns[column_count]
+ *   char     preamble[preamble_size]
+ *
+ * followed by any number of blocks:
+ *
+ *   char     magic[4]        "BLK1"
+ *   uint32_t row_count
+ *   column 0 values[row_count], column 1 values[row_count], ...
+ *
+ * The preamble holds the system info lines of the csv log so that
+ * mangohud-log2csv can reproduce the csv output exactly.
+ */
+
+class BinaryLogWriter {
+public:
+  static constexpr uint32_t version = 1;
+  static constexpr size_t rows_per_block = 256;
+  static constexpr size_t column_name_size = 31;
+
+  // Writes the header, blocks follow in the same file
+  void open(LogFile& file, const std::string& preamble,
+            const std::vector<log_column>& columns);
+  void append(const logSample& sample);
+  void flush();
+  void close();
+  bool is_open() const { return m_out != nullptr; }
+
+private:
+  template<typename T>
+  void put(size_t column, T value);
+
+  LogFile *m_out = nullptr;
+  std::vector<log_column> m_schema;
+  std::vector<std::vector<char>> m_columns;
+  size_t m_rows = 0;
+};
+
+#endif //MANGOHUD_LOG_BINARY_H
@@ -0,0 +1,132 @@
+#include <spdlog/spdlog.h>
+#include "log_file.h"
+#ifndef _WIN32
+#include "loaders/loader_zstd.h"
+#include "loaders/loader_lz4.h"
+#endif
+
+std::string log_compression_extension(enum log_compression_codec codec) {
+  switch (codec) {
+    case LOG_COMPRESSION_ZSTD: return ".zst";
+    case LOG_COMPRESSION_LZ4: return ".lz4";
+    default: return "";
+  }
+}
+
+bool log_compression_available(enum log_compression_codec codec) {
+#ifndef _WIN32
+  switch (codec) {
+    case LOG_COMPRESSION_NONE: return true;
+    case LOG_COMPRESSION_ZSTD: return get_libzstd()->IsLoaded();
+    case LOG_COMPRESSION_LZ4: return get_liblz4()->IsLoaded();
+  }
+  return false;
+#else
+  return codec == LOG_COMPRESSION_NONE;
+#endif
+}
+
+enum log_compression_codec LogFile::set_compression(log_compression compression) {
+  free_context();
+
+  if (!log_compression_available(compression.codec)) {
+    SPDLOG_ERROR("Log compression library not available, writing uncompressed log");
+    compression.codec = LOG_COMPRESSION_NONE;
+  }
+
+#ifndef _WIN32
+  if (compression.codec == LOG_COMPRESSION_ZSTD) {
+    m_zstd_ctx = get_libzstd()->ZSTD_createCCtx();
+    if (!m_zstd_ctx) {
+      SPDLOG_ERROR("Failed to create zstd context, writing uncompressed log");
+      compression.codec = LOG_COMPRESSION_NONE;
+    }
+  }
+#endif
+
+  m_compression = compression;
+  return m_compression.codec;
+}
+
+bool LogFile::open(const std::string& path) {
+  m_out.open(path, std::ios::out | std::ios::binary | std::ios::app);
+  if (!m_out) {
+    SPDLOG_ERROR("Failed to open log file '{}'", path);
+    return false;
+  }
+
+  m_pending.clear();
+  m_pending.reserve(frame_size);
+  return true;
+}
+
+void LogFile::write(const char *data, size_t size) {
+  if (m_compression.codec == LOG_COMPRESSION_NONE) {
+    m_out.write(data, size);
+    return;
+  }
+
+  m_pending.append(data, size);
+  if (m_pending.size() >= frame_size)
+    compress_frame();
+}
+
+void LogFile::flush(bool force) {
+  if (force || m_pending.size() >= frame_size)
+    compress_frame();
+  m_out.flush();
+}
+
+bool LogFile::compress_frame() {
+  if (m_pending.empty())
+    return true;
+
+#ifndef _WIN32
+  size_t written = 0;
+  if (m_compression.codec == LOG_COMPRESSION_ZSTD) {
+    auto zstd = get_libzstd();
+    m_frame.resize(zstd->ZSTD_compressBound(m_pending.size()));
+    written = zstd->ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(m_zstd_ctx),
+                                      m_frame.data(), m_frame.size(),
+                                      m_pending.data(), m_pending.size(),
+                                      m_compression.level);
+    if (zstd->ZSTD_isError(written)) {
+      SPDLOG_ERROR("zstd log compression failed: {}", zstd->ZSTD_getErrorName(written));
+      return false;
+    }
+  } else if (m_compression.codec == LOG_COMPRESSION_LZ4) {
+    auto lz4 = get_liblz4();
+    lz4f_preferences prefs {};
+    prefs.compressionLevel = m_compression.level;
+    prefs.frameInfo.contentSize = m_pending.size();
+    m_frame.resize(lz4->LZ4F_compressFrameBound(m_pending.size(), &prefs));
+    written = lz4->LZ4F_compressFrame(m_frame.data(), m_frame.size(),
+                                      m_pending.data(), m_pending.size(), &prefs);
+    if (lz4->LZ4F_isError(written)) {
+      SPDLOG_ERROR("lz4 log compression failed: {}", lz4->LZ4F_getErrorName(written));
+      return false;
+    }
+  }
+
+  m_out.write(m_frame.data(), written);
+#endif
+  m_pending.clear();
+  return true;
+}
+
+void LogFile::close() {
+  if (m_out.is_open()) {
+    flush(true);
+    m_out.close();
+  }
+  free_context();
+  m_compression = {LOG_COMPRESSION_NONE, 0};
+}
+
+void LogFile::free_context() {
+#ifndef _WIN32
+  if (m_zstd_ctx)
+    get_libzstd()->ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_zstd_ctx));
+#endif
+  m_zstd_ctx = nullptr;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef MANGOHUD_LOG_FILE_H
+#define MANGOHUD_LOG_FILE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "overlay_params.h"
+
+// Extension appended to the log file name, empty for uncompressed logs
+std::string log_compression_extension(enum log_compression_codec codec);
+
+// Loads the codec library, returns false if it isn't available
+bool log_compression_available(enum log_compression_codec codec);
+
+// Output file of a log. With compression, the buffered data is written as
+// independent zstd/lz4 frames, so everything up to the last complete frame
+// can be decompressed even if the game crashes.
+class LogFile {
+public:
+  // Pending data is compressed once it reaches this size or on close()
+  static constexpr size_t frame_size = 64 * 1024;
+
+  ~LogFile() { close(); }
+
+  // Loads the codec and creates its context, falling back to no compression
+  // when either fails. Returns the codec the next file will use, so the file
+  // name can be picked to match before open().
+  enum log_compression_codec set_compression(log_compression compression);
+  bool open(const std::string& path);
+  void write(const char *data, size_t size);
+  void write(const std::string& data) { write(data.data(), data.size()); }
+  // Uncompressed data goes straight to disk, compressed data is only
+  // written once a whole frame is pending unless force is set
+  void flush(bool force = false);
+  // Also releases the codec context, set_compression() again before the next open()
+  void close();
+  bool is_open() const { return m_out.is_open(); }
+
+private:
+  bool compress_frame();
+  void free_context();
+
+  std::ofstream m_out;
+  log_compression m_compression {LOG_COMPRESSION_NONE, 0};
+  std::string m_pending;
+  std::vector<char> m_frame;
+  void *m_zstd_ctx = nullptr;
+};
+
+#endif //MANGOHUD_LOG_FILE_H
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "log_schema.h"
+#include "logging.h"
+#include "cpu.h"
+#include "gpu.h"
+#include "hud_elements.h"
+#include "iostats.h"
+#include "memory.h"
+#include "overhead.h"
+#include "pressure.h"
+#include "thread_stats.h"
+
+template<typename T>
+static std::function<double(const logSample&)> field(T logData::*member) {
+  return [member](const logSample& sample) { return static_cast<double>(sample.data.*member); };
+}
+
+static std::function<float()> active_gpu_metric(float (*get)(const gpu_metrics&)) {
+  return [get]() -> float {
+    if (!gpus)
+      return 0.f;
+    auto gpu = gpus->active_gpu();
+    return gpu ? get(gpu->metrics) : 0.f;
+  };
+}
+
+// Aggregate of an active gpu metric over one of the sampler's windows
+static std::function<float()> active_gpu_window(gpu_window_field field, gpu_window window,
+                                                float gpu_window_stats::*stat) {
+  return [=]() -> float {
+    if (!gpus)
+      return 0.f;
+    auto gpu = gpus->active_gpu();
+    return gpu ? gpu->window_stats(field, window).*stat : 0.f;
+  };
+}
+
+static std::vector<log_column> builtin_columns() {
+  std::vector<log_column> columns {
+    // Default csv columns, in csv order
+    {"fps",            LOG_COLUMN_F64, LOG_SOURCE_NONE,                         field(&logData::fps),            {}},
+    {"frametime",      LOG_COLUMN_F32, LOG_SOURCE_NONE,                         field(&logData::frametime),      {}},
+    {"cpu_load",       LOG_COLUMN_F32, LOG_SOURCE_CPU,                          field(&logData::cpu_load),       {}},
+    {"cpu_power",      LOG_COLUMN_F32, LOG_SOURCE_CPU | LOG_SOURCE_CPU_POWER,   field(&logData::cpu_power),      {}},
+    {"gpu_load",       LOG_COLUMN_I32, LOG_SOURCE_GPU,                          field(&logData::gpu_load),       {}},
+    {"cpu_temp",       LOG_COLUMN_I32, LOG_SOURCE_CPU | LOG_SOURCE_CPU_TEMP,    field(&logData::cpu_temp),       {}},
+    {"gpu_temp",       LOG_COLUMN_I32, LOG_SOURCE_GPU,                          field(&logData::gpu_temp),       {}},
+    {"gpu_core_clock", LOG_COLUMN_I32, LOG_SOURCE_GPU,                          field(&logData::gpu_core_clock), {}},
+    {"gpu_mem_clock",  LOG_COLUMN_I32, LOG_SOURCE_GPU,                          field(&logData::gpu_mem_clock),  {}},
+    {"gpu_vram_used",  LOG_COLUMN_F32, LOG_SOURCE_GPU,                          field(&logData::gpu_vram_used),  {}},
+    {"gpu_power",      LOG_COLUMN_I32, LOG_SOURCE_GPU,                          field(&logData::gpu_power),      {}},
+    {"ram_used",       LOG_COLUMN_F32, LOG_SOURCE_MEMINFO,                      field(&logData::ram_used),       {}},
+    {"swap_used",      LOG_COLUMN_F32, LOG_SOURCE_MEMINFO,                      field(&logData::swap_used),      {}},
+    {"process_rss",    LOG_COLUMN_F32, LOG_SOURCE_PROCMEM,                      field(&logData::process_rss),    {}},
+    {"cpu_mhz",        LOG_COLUMN_I32, LOG_SOURCE_CPU | LOG_SOURCE_CPU_MHZ,     field(&logData::cpu_mhz),        {}},
+    {"elapsed",        LOG_COLUMN_I64, LOG_SOURCE_NONE, [](const logSample& sample) {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(sample.data.previous).count());
+      }, {}},
+
+    // Optional columns, only logged when selected with log_columns=
+    {"gpu_gtt_used",      LOG_COLUMN_F32, LOG_SOURCE_GPU, {},
+      active_gpu_metric([](const gpu_metrics& m) { return m.gtt_used; })},
+    {"gpu_junction_temp", LOG_COLUMN_I32, LOG_SOURCE_GPU, {},
+      active_gpu_metric([](const gpu_metrics& m) { return float(m.junction_temp); })},
+    {"gpu_mem_temp",      LOG_COLUMN_I32, LOG_SOURCE_GPU, {},
+      active_gpu_metric([](const gpu_metrics& m) { return float(m.memory_temp); })},
+    {"gpu_fan",           LOG_COLUMN_I32, LOG_SOURCE_GPU, {},
+      active_gpu_metric([](const gpu_metrics& m) { return float(m.fan_speed); })},
+    {"gamescope_latency",       LOG_COLUMN_F32, LOG_SOURCE_GAMESCOPE, {},
+      []() { return HUDElements.gamescope_latency_ms.load(); }},
+    {"gamescope_app_frametime", LOG_COLUMN_F32, LOG_SOURCE_GAMESCOPE, {},
+      []() { return HUDElements.gamescope_app_frametime_ms.load(); }},
+    // Short power transients that the 500 ms mean of gpu_power smooths over
+    {"gpu_power_max_100ms", LOG_COLUMN_F32, LOG_SOURCE_GPU, {},
+      active_gpu_window(GPU_FIELD_POWER, GPU_WINDOW_100MS, &gpu_window_stats::max)},
+    {"gpu_power_p95_1s",    LOG_COLUMN_F32, LOG_SOURCE_GPU, {},
+      active_gpu_window(GPU_FIELD_POWER, GPU_WINDOW_1S, &gpu_window_stats::p95)},
+    {"gpu_load_max_100ms",  LOG_COLUMN_I32, LOG_SOURCE_GPU, {},
+      active_gpu_window(GPU_FIELD_LOAD, GPU_WINDOW_100MS, &gpu_window_stats::max)},
+    // percent of one core MangoHud spent polling and rendering
+    {"overhead_load",           LOG_COLUMN_F32, LOG_SOURCE_NONE, {},
+      []() { return g_overhead.total_load(); }},
+  };
+
+#ifdef __linux__
+  columns.push_back({"io_read",  LOG_COLUMN_F32, LOG_SOURCE_IO, {},
+                     []() { return g_io_stats.per_second.read; }});
+  columns.push_back({"io_write", LOG_COLUMN_F32, LOG_SOURCE_IO, {},
+                     []() { return g_io_stats.per_second.write; }});
+  // KB/s summed over the interfaces selected with network=
+  columns.push_back({"net_tx", LOG_COLUMN_F32, LOG_SOURCE_NET, {}, []() {
+    float total = 0.f;
+    auto net = HUDElements.net.load();
+    if (!net)
+      return total;
+    if (auto throughput = net->throughput())
+      for (auto& iface : *throughput)
+        total += iface.txBps / 1000.f;
+    return total;
+  }});
+  columns.push_back({"net_rx", LOG_COLUMN_F32, LOG_SOURCE_NET, {}, []() {
+    float total = 0.f;
+    auto net = HUDElements.net.load();
+    if (!net)
+      return total;
+    if (auto throughput = net->throughput())
+      for (auto& iface : *throughput)
+        total += iface.rxBps / 1000.f;
+    return total;
+  }});
+  // percent of the sampling period stalled on cpu, memory or io
+  static const std::pair<const char*, pressure_resource> pressure_columns[] = {
+    {"cpu", PRESSURE_CPU}, {"memory", PRESSURE_MEMORY}, {"io", PRESSURE_IO},
+  };
+  for (auto& [name, resource] : pressure_columns) {
+    columns.push_back({std::string("psi_") + name, LOG_COLUMN_F32, LOG_SOURCE_PRESSURE, {},
+                       [resource = resource]() {
+                         auto pressure = g_pressure.load();
+                         return pressure ? (*pressure)[resource].some.load() : 0.f;
+                       }});
+    columns.push_back({std::string("psi_") + name + "_full", LOG_COLUMN_F32, LOG_SOURCE_PRESSURE, {},
+                       [resource = resource]() {
+                         auto pressure = g_pressure.load();
+                         return pressure ? (*pressure)[resource].full.load() : 0.f;
+                       }});
+  }
+  // stall spikes caught by the PSI triggers since start, all resources
+  columns.push_back({"psi_events", LOG_COLUMN_I32, LOG_SOURCE_PRESSURE, {}, []() {
+    uint32_t events = 0;
+    if (auto pressure = g_pressure.load())
+      for (size_t i = 0; i < PRESSURE_COUNT; i++)
+        events += (*pressure)[pressure_resource(i)].events;
+    return float(events);
+  }});
+  // MiB, from /proc/meminfo
+  static const std::pair<const char*, meminfo_key> meminfo_columns[] = {
+    {"mem_dirty", MEMINFO_DIRTY}, {"mem_writeback", MEMINFO_WRITEBACK}, {"mem_shmem", MEMINFO_SHMEM},
+  };
+  for (auto& [name, key] : meminfo_columns)
+    columns.push_back({name, LOG_COLUMN_F32, LOG_SOURCE_MEMINFO_EXT, {},
+                       [key = key]() { return get_meminfo()->mib(key); }});
+  columns.push_back({"hugepages_used", LOG_COLUMN_I64, LOG_SOURCE_MEMINFO_EXT, {}, []() {
+    auto meminfo = get_meminfo();
+    return double(meminfo->values[MEMINFO_HUGEPAGES_TOTAL] - meminfo->values[MEMINFO_HUGEPAGES_FREE]);
+  }});
+  // percent of one core used by the game's main thread
+  columns.push_back({"main_thread_load", LOG_COLUMN_F32, LOG_SOURCE_THREADS, {},
+                     []() { return g_thread_stats.main_thread_load(); }});
+  // Joules since the sampler started, a session's energy is last row minus first
+  columns.push_back({"gpu_energy", LOG_COLUMN_F64, LOG_SOURCE_GPU, {}, []() {
+    auto gpu = gpus ? gpus->active_gpu() : nullptr;
+    return gpu && gpu->amdgpu ? gpu->amdgpu->energy().joules : 0.;
+  }});
+#endif
+
+  return columns;
+}
+
+static std::vector<log_column_group> builtin_groups() {
+  return {
+    {"core_load", []() {
+      std::vector<log_column> columns;
+      for (size_t i = 0; i < cpuStats.GetCPUData().size(); i++) {
+        auto id = cpuStats.GetCPUData()[i].cpu_id;
+        columns.push_back({"core" + std::to_string(id) + "_load", LOG_COLUMN_F32, LOG_SOURCE_CPU, {},
+                           [i]() { auto& loads = cpuStats.GetCoreLoad(); return i < loads.size() ? loads[i] : 0.f; }});
+      }
+      return columns;
+    }},
+    {"core_mhz", []() {
+      std::vector<log_column> columns;
+      for (size_t i = 0; i < cpuStats.GetCPUData().size(); i++) {
+        auto id = cpuStats.GetCPUData()[i].cpu_id;
+        columns.push_back({"core" + std::to_string(id) + "_mhz", LOG_COLUMN_I32, LOG_SOURCE_CPU | LOG_SOURCE_CPU_MHZ, {},
+                           [i]() { auto& cpus = cpuStats.GetCPUData(); return i < cpus.size() ? float(cpus[i].mhz) : 0.f; }});
+      }
+      return columns;
+    }},
+    // average microseconds per call of each stage seen so far
+    {"overhead", []() {
+      std::vector<log_column> columns;
+      auto summary = g_overhead.summary();
+      if (!summary)
+        return columns;
+      for (auto& stage : *summary) {
+        auto name = stage.name;
+        columns.push_back({"overhead_" + name + "_us", LOG_COLUMN_F32, LOG_SOURCE_NONE, {}, [name]() {
+          auto summary = g_overhead.summary();
+          if (summary)
+            for (auto& s : *summary)
+              if (s.name == name)
+                return s.avg_us;
+          return 0.f;
+        }});
+      }
+      return columns;
+    }},
+  };
+}
+
+static std::vector<log_column>& column_registry() {
+  static std::vector<log_column> registry = builtin_columns();
+  return registry;
+}
+
+static std::vector<log_column_group>& group_registry() {
+  static std::vector<log_column_group> registry = builtin_groups();
+  return registry;
+}
+
+void register_log_column(const log_column& column) {
+  column_registry().push_back(column);
+}
+
+void register_log_column_group(const log_column_group& group) {
+  group_registry().push_back(group);
+}
+
+void LogSchema::select(const std::vector<std::string>& names) {
+  auto& registry = column_registry();
+  m_columns.clear();
+  m_samplers.clear();
+  m_sources = LOG_SOURCE_NONE;
+
+  std::vector<log_column> wanted;
+  if (names.empty()) {
+    // default csv columns are the ones stored directly in logData
+    for (auto& col : registry)
+      if (col.get)
+        wanted.push_back(col);
+  } else {
+    for (auto& name : names) {
+      auto col = std::find_if(registry.begin(), registry.end(),
+                              [&](const log_column& c) { return c.name == name; });
+      if (col != registry.end()) {
+        wanted.push_back(*col);
+        continue;
+      }
+
+      auto& groups = group_registry();
+      auto group = std::find_if(groups.begin(), groups.end(),
+                                [&](const log_column_group& g) { return g.name == name; });
+      if (group != groups.end()) {
+        auto expanded = group->expand();
+        wanted.insert(wanted.end(), expanded.begin(), expanded.end());
+        continue;
+      }
+
+      SPDLOG_ERROR("Unknown log column '{}'", name);
+    }
+
+    // elapsed is needed to make sense of the log
+    if (std::none_of(wanted.begin(), wanted.end(), [](const log_column& c) { return c.name == "elapsed"; }))
+      wanted.push_back(*std::find_if(registry.begin(), registry.end(),
+                                     [](const log_column& c) { return c.name == "elapsed"; }));
+  }
+
+  for (auto& col : wanted) {
+    if (!col.get) {
+      size_t slot = m_samplers.size();
+      m_samplers.push_back(col.sample);
+      col.get = [slot](const logSample& sample) { return slot < sample.extra.size() ? sample.extra[slot] : 0.; };
+    }
+    m_sources |= col.sources;
+    m_columns.push_back(col);
+  }
+}
+
+void LogSchema::sample(std::vector<double>& extra) const {
+  extra.resize(m_samplers.size());
+  for (size_t i = 0; i < m_samplers.size(); i++)
+    extra[i] = m_samplers[i]();
+}
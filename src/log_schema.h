@@ -0,0 +1,77 @@
+#pragma once
+#ifndef MANGOHUD_LOG_SCHEMA_H
+#define MANGOHUD_LOG_SCHEMA_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct logSample;
+
+enum log_column_type : uint8_t {
+  LOG_COLUMN_F64,
+  LOG_COLUMN_F32,
+  LOG_COLUMN_I32,
+  LOG_COLUMN_I64,
+};
+
+// Metric sources that have to be polled by hw_info_updater for a column
+enum log_source : uint32_t {
+  LOG_SOURCE_NONE       = 0,
+  LOG_SOURCE_CPU        = (1u << 0),
+  LOG_SOURCE_CPU_MHZ    = (1u << 1),
+  LOG_SOURCE_CPU_TEMP   = (1u << 2),
+  LOG_SOURCE_CPU_POWER  = (1u << 3),
+  LOG_SOURCE_GPU        = (1u << 4),
+  LOG_SOURCE_MEMINFO    = (1u << 5),
+  LOG_SOURCE_PROCMEM    = (1u << 6),
+  LOG_SOURCE_IO         = (1u << 7),
+  LOG_SOURCE_NET        = (1u << 8),
+  LOG_SOURCE_GAMESCOPE  = (1u << 9),
+  LOG_SOURCE_PRESSURE   = (1u << 10),
+  LOG_SOURCE_THREADS    = (1u << 11),
+  // meminfo keys past the ones needed for ram_used and swap_used
+  LOG_SOURCE_MEMINFO_EXT = (1u << 12),
+};
+
+struct log_column {
+  std::string name;
+  log_column_type type;
+  uint32_t sources;
+  // Reads the value back from a logged sample
+  std::function<double(const logSample&)> get;
+  // Columns outside of the fixed logData fields provide a sampler, its
+  // value is stored in logSample::extra
+  std::function<double()> sample;
+};
+
+// A registered name can stand for several columns, e.g. one per cpu core.
+// expand() is called when logging starts.
+struct log_column_group {
+  std::string name;
+  std::function<std::vector<log_column>()> expand;
+};
+
+void register_log_column(const log_column& column);
+void register_log_column_group(const log_column_group& group);
+
+class LogSchema {
+public:
+  // Resolves the log_columns= option against the registered columns.
+  // An empty selection gives the default csv columns.
+  void select(const std::vector<std::string>& names);
+
+  const std::vector<log_column>& columns() const { return m_columns; }
+  bool wants(log_source source) const { return m_sources & source; }
+
+  // Fills logSample::extra from the selected samplers
+  void sample(std::vector<double>& extra) const;
+
+private:
+  std::vector<log_column> m_columns;
+  std::vector<std::function<double()>> m_samplers;
+  uint32_t m_sources = LOG_SOURCE_NONE;
+};
+
+#endif //MANGOHUD_LOG_SCHEMA_H
@@ -17,10 +17,7 @@ string os, cpu, gpu, ram, kernel, driver, cpusched;
 bool sysInfoFetched = false;
 double fps;
 float frametime;
-logData currentLogData = {};
 std::shared_ptr<Logger> logger;
-ofstream output_file;
-std::thread log_thread;
 
 string exec(string command) {
 #ifndef _WIN32
@@ -60,21 +57,37 @@ static void upload_files(const std::vector<std::string>& logFiles){
   exec("xdg-open " + url);
 }
 
-static bool compareByFps(const logData &a, const logData &b)
-{
-    return a.fps < b.fps;
+void logSummaryColumn::add(float value){
+  total += value;
+  peak = std::max(peak, value);
+  sketch.add(value);
+}
+
+void logSummary::add(const logData& data){
+  count++;
+  frametime.add(data.frametime);
+  gpu_load.add(data.gpu_load);
+  cpu_load.add(data.cpu_load);
+  gpu_temp.add(data.gpu_temp);
+  cpu_temp.add(data.cpu_temp);
+  vram.add(data.gpu_vram_used);
+  ram.add(data.ram_used);
+  swap.add(data.swap_used);
 }
 
-static void writeSummary(string filename){
-  auto& logArray = logger->get_log_data();
-  // if the log is stopped/started too fast we might end up with an empty vector.
+static void writeSummary(const logSummary& summary, string filename){
+  // if the log is stopped/started too fast we might end up with an empty summary.
   // in that case, just bail.
-  if (logArray.size() == 0){
-    logger->stop_logging();
+  if (summary.count == 0)
     return;
-  }
 
-  filename = filename.substr(0, filename.size() - 4);
+  // strip the compression and the log extension
+  for (auto codec : {LOG_COMPRESSION_ZSTD, LOG_COMPRESSION_LZ4}){
+    auto ext = log_compression_extension(codec);
+    if (filename.size() > ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0)
+      filename.resize(filename.size() - ext.size());
+  }
+  filename = filename.substr(0, filename.rfind('.'));
   filename += "_summary.csv";
   SPDLOG_INFO("{}", filename);
   SPDLOG_DEBUG("Writing summary log file [{}]", filename);
@@ -86,103 +99,44 @@ static void writeSummary(string filename){
         << "Average RAM Used," << "Average Swap Used," << "Peak GPU Load,"
         << "Peak CPU Load," << "Peak GPU Temp," << "Peak CPU Temp,"
         << "Peak VRAM Used," << "Peak RAM Used," << "Peak Swap Used" << "\n";
-    std::vector<logData> sorted = logArray;
-    std::sort(sorted.begin(), sorted.end(), compareByFps);
-    float total = 0.0f;
-    float total_gpu = 0.0f;
-    float total_cpu = 0.0f;
-    int total_gpu_temp = 0.0f;
-    int total_cpu_temp = 0.0f;
-    float total_vram = 0.0f;
-    float total_ram = 0.0f;
-    float total_swap = 0.0f;
-    int peak_gpu = 0.0f;
-    float peak_cpu = 0.0f;
-    int peak_gpu_temp = 0.0f;
-    int peak_cpu_temp = 0.0f;
-    float peak_vram = 0.0f;
-    float peak_ram = 0.0f;
-    float peak_swap = 0.0f;
     float result;
-    std::vector<float> fps_values;
-    for (auto& data : sorted)
-      fps_values.push_back(data.frametime);
-
     std::unique_ptr<fpsMetrics> fpsmetrics;
     std::vector<std::string> metrics {"0.001", "0.01", "0.97"};
-    fpsmetrics = std::make_unique<fpsMetrics>(metrics, fps_values);
+    fpsmetrics = std::make_unique<fpsMetrics>(metrics, summary.frametime.sketch);
     auto metrics_copy = fpsmetrics->copy_metrics();
     for (auto& metric : metrics_copy)
       out << metric.value << ",";
 
     fpsmetrics.reset();
 
-    total = 0;
-    for (auto input : sorted){
-      total = total + input.frametime;
-      total_gpu = total_gpu + input.gpu_load;
-      total_cpu = total_cpu + input.cpu_load;
-      total_gpu_temp = total_gpu_temp + input.gpu_temp;
-      total_cpu_temp = total_cpu_temp + input.cpu_temp;
-      total_vram = total_vram + input.gpu_vram_used;
-      total_ram = total_ram + input.ram_used;
-      total_swap = total_swap + input.swap_used;
-      peak_gpu = std::max(peak_gpu, input.gpu_load);
-      peak_cpu = std::max(peak_cpu, input.cpu_load);
-      peak_gpu_temp = std::max(peak_gpu_temp, input.gpu_temp);
-      peak_cpu_temp = std::max(peak_cpu_temp, input.cpu_temp);
-      peak_vram = std::max(peak_vram, input.gpu_vram_used);
-      peak_ram = std::max(peak_ram, input.ram_used);
-      peak_swap = std::max(peak_swap, input.swap_used);
-    }
     // Average FPS
-    result = 1000 / (total / sorted.size());
+    result = 1000 / summary.frametime.average(summary.count);
     out << fixed << setprecision(1) << result << ",";
-    // GPU Load (Average)
-    result = total_gpu / sorted.size();
-    out << result << ",";
-    // CPU Load (Average)
-    result = total_cpu / sorted.size();
-    out << result << ",";
-    // Average Frame Time
-    result = total / sorted.size();
-    out << result << ",";
-    // Average GPU Temp
-    result = total_gpu_temp / sorted.size();
-    out << result << ",";
-    // Average CPU Temp
-    result = total_cpu_temp / sorted.size();
-    out << result << ",";
-    // Average VRAM Used
-    result = total_vram / sorted.size();
-    out << result << ",";
-    // Average RAM Used
-    result = total_ram / sorted.size();
-    out << result << ",";
-    // Average Swap Used
-    result = total_swap / sorted.size();
-    out << result << ",";
-    // Peak GPU Load
-    out << peak_gpu << ",";
-    // Peak CPU Load
-    out << peak_cpu << ",";
-    // Peak GPU Temp
-    out << peak_gpu_temp << ",";
-    // Peak CPU Temp
-    out << peak_cpu_temp << ",";
-    // Peak VRAM Used
-    out << peak_vram << ",";
-    // Peak RAM Used
-    out << peak_ram << ",";
-    // Peak Swap Used
-    out << peak_swap;
+    // GPU Load, CPU Load, Average Frame Time
+    for (auto column : {&summary.gpu_load, &summary.cpu_load, &summary.frametime})
+      out << column->average(summary.count) << ",";
+    // Average GPU/CPU Temp, temps are logged as integers and so are their averages
+    for (auto column : {&summary.gpu_temp, &summary.cpu_temp})
+      out << static_cast<float>(static_cast<uint64_t>(column->total) / summary.count) << ",";
+    // Average VRAM/RAM/Swap Used
+    for (auto column : {&summary.vram, &summary.ram, &summary.swap})
+      out << column->average(summary.count) << ",";
+    // Peak GPU Load, CPU Load, GPU Temp, CPU Temp, VRAM, RAM and Swap Used.
+    // Loads and temps are logged as integers.
+    out << static_cast<int>(summary.gpu_load.peak) << ",";
+    out << summary.cpu_load.peak << ",";
+    out << static_cast<int>(summary.gpu_temp.peak) << ",";
+    out << static_cast<int>(summary.cpu_temp.peak) << ",";
+    out << summary.vram.peak << ",";
+    out << summary.ram.peak << ",";
+    out << summary.swap.peak;
   } else {
     SPDLOG_ERROR("Failed to write log file");
   }
   out.close();
 }
 
-static void writeFileHeaders(ofstream& out){
+static void writeFileHeaders(ostream& out){
     auto params = get_params();  
     if (params->enabled[OVERLAY_PARAM_ENABLED_log_versioning]){
       printf("log versioning");
@@ -196,49 +150,123 @@ static void writeFileHeaders(ofstream& out){
 
     if (params->enabled[OVERLAY_PARAM_ENABLED_log_versioning])
       out << "--------------------FRAME METRICS--------------------" << endl;
+}
 
-    out << "fps," << "frametime," << "cpu_load," << "cpu_power," << "gpu_load,"
-        << "cpu_temp," << "gpu_temp," << "gpu_core_clock," << "gpu_mem_clock,"
-        << "gpu_vram_used," << "gpu_power," << "ram_used," << "swap_used,"
-        << "process_rss," << "cpu_mhz," << "elapsed" << endl;
+static void writeColumnHeaders(ostream& out, const std::vector<log_column>& columns){
+    for (size_t i = 0; i < columns.size(); i++)
+      out << columns[i].name << (i + 1 < columns.size() ? "," : "\n");
+}
 
+void Logger::writeToFile(const logSample& sample){
+  auto& columns = schema()->columns();
+
+  if (!m_file.is_open()){
+    if (!m_file.open(m_log_files.back())){
+      printf("MANGOHUD: Failed to write log file\n");
+      return;
+    }
+
+    std::ostringstream preamble;
+    writeFileHeaders(preamble);
+    if (log_format == LOG_FORMAT_BINARY){
+      m_binary_file.open(m_file, preamble.str(), columns);
+    } else {
+      writeColumnHeaders(preamble, columns);
+      m_file.write(preamble.str());
+    }
+  }
+
+  if (log_format == LOG_FORMAT_BINARY){
+    m_binary_file.append(sample);
+    return;
+  }
+
+  for (size_t i = 0; i < columns.size(); i++){
+    double value = columns[i].get(sample);
+    switch (columns[i].type){
+      case LOG_COLUMN_F64: m_csv_buffer << value; break;
+      case LOG_COLUMN_F32: m_csv_buffer << static_cast<float>(value); break;
+      case LOG_COLUMN_I32: m_csv_buffer << static_cast<int>(value); break;
+      case LOG_COLUMN_I64: m_csv_buffer << static_cast<int64_t>(value); break;
+    }
+    m_csv_buffer << (i + 1 < columns.size() ? "," : "\n");
+  }
 }
 
-void Logger::writeToFile(){
-  if (!output_file){
-    output_file.open(m_log_files.back(), ios::out | ios::app);
-    writeFileHeaders(output_file);
+void Logger::flushFile(){
+  if (!m_file.is_open())
+    return;
+
+  if (m_csv_buffer.tellp() > 0){
+    m_file.write(m_csv_buffer.str());
+    m_csv_buffer.str("");
   }
+  m_file.flush();
+}
 
-  auto& logArray = logger->get_log_data();
-  if (output_file && !logArray.empty()){
-    output_file << logArray.back().fps << ",";
-    output_file << logArray.back().frametime << ",";
-    output_file << logArray.back().cpu_load << ",";
-    output_file << logArray.back().cpu_power << ",";
-    output_file << logArray.back().gpu_load << ",";
-    output_file << logArray.back().cpu_temp << ",";
-    output_file << logArray.back().gpu_temp << ",";
-    output_file << logArray.back().gpu_core_clock << ",";
-    output_file << logArray.back().gpu_mem_clock << ",";
-    output_file << logArray.back().gpu_vram_used << ",";
-    output_file << logArray.back().gpu_power << ",";
-    output_file << logArray.back().ram_used << ",";
-    output_file << logArray.back().swap_used << ",";
-    output_file << logArray.back().process_rss << ",";
-    output_file << logArray.back().cpu_mhz << ",";
-    output_file << std::chrono::duration_cast<std::chrono::nanoseconds>(logArray.back().previous).count() << "\n";
-    output_file.flush();
-  } else {
-    printf("MANGOHUD: Failed to write log file\n");
+void Logger::writer_thread(){
+  logSample sample;
+  while (true){
+    bool active = is_active();
+    while (m_write_queue.pop(sample))
+      writeToFile(sample);
+    flushFile();
+
+    if (!active)
+      break;
+
+    std::unique_lock<std::mutex> lck(m_writer_mtx);
+    m_writer_cv.wait_for(lck, std::chrono::milliseconds(100), [this] {
+      return !is_active() || m_write_queue.size() >= m_write_queue.capacity() / 2;
+    });
+  }
+  finish_log();
+}
+
+// Runs on the writer thread once logging stopped, whether stop_logging()
+// or try_log() running out of log_duration stopped it
+void Logger::finish_log(){
+  auto log_end = Clock::now();
+  // a try_log() that got in before the stop may have pushed and added to
+  // the summary after the last drain, holding its lock keeps it out now
+  std::lock_guard<std::mutex> consumer(m_consumer_mtx);
+  logSample sample;
+  while (m_write_queue.pop(sample))
+    writeToFile(sample);
+
+  if (m_dropped_samples)
+    SPDLOG_WARN("Log write queue was full, dropped {} samples", m_dropped_samples.load());
+
+  calculate_benchmark_data();
+  try {
+      m_binary_file.close();
+      flushFile();
+      m_file.close();
+  } catch (...) {
+    SPDLOG_INFO("Something went wrong when closing the log file");
   }
+
+  if (!m_log_files.empty())
+    writeSummary(m_log_summary, m_log_files.back());
+  else
+    SPDLOG_INFO("Can't write summary because m_log_files is empty");
+
+  // the HUD shows the benchmark data once this is recent
+  m_log_end = log_end;
+#ifdef __linux__
+  control_client_check(get_params()->control, global_control_client, gpu.c_str());
+  const char * cmd = "LoggingFinished";
+  control_send(global_control_client, cmd, strlen(cmd), 0, 0);
+#endif
 }
 
-static string get_log_suffix(){
+static string get_log_suffix(enum log_format format, enum log_compression_codec codec){
   time_t now_log = time(0);
   tm *log_time = localtime(&now_log);
   std::ostringstream buffer;
-  buffer << std::put_time(log_time, "%Y-%m-%d_%H-%M-%S") << ".csv";
+  buffer << std::put_time(log_time, "%Y-%m-%d_%H-%M-%S")
+         << (format == LOG_FORMAT_BINARY ? ".mhlog" : ".csv")
+         << log_compression_extension(codec);
   string log_name = buffer.str();
   return log_name;
 }
@@ -247,92 +275,115 @@ Logger::Logger(const overlay_params* in_params)
   : output_folder(in_params->output_folder),
 	log_interval(in_params->log_interval),
 	log_duration(in_params->log_duration),
+	log_format(in_params->log_format),
+	log_columns(in_params->log_columns),
+	log_compression(in_params->log_compression),
     m_logging_on(false),
+    m_write_queue(4096),
+    m_dropped_samples(0),
     m_values_valid(false)
 {
   if(output_folder.empty()) output_folder = std::getenv("HOME");
+  m_schema.store(std::make_shared<const LogSchema>());
   m_log_end = Clock::now() - 15s;
   SPDLOG_DEBUG("Logger constructed!");
 }
 
+Logger::~Logger() {
+  stop_logging();
+}
+
 void Logger::start_logging() {
+  std::lock_guard<std::mutex> lifecycle(m_lifecycle_mtx);
   if(m_logging_on) return;
+  // the last log ran out of log_duration and may still be finishing
+  if (m_log_thread.joinable()) m_log_thread.join();
+  if (m_writer_thread.joinable()) m_writer_thread.join();
   m_values_valid = false;
-  m_logging_on = true;
+  m_write_queue.clear();
+  m_dropped_samples = 0;
+  clear_log_data();
   m_log_start = Clock::now();
+  // hide the last log's benchmark data until this one is finished
+  m_log_end = m_log_start - 15s;
+
+  auto schema = std::make_shared<LogSchema>();
+  schema->select(log_columns);
+  m_schema.store(schema);
 
   std::string program = get_wine_exe_name();
 
   if (program.empty())
       program = get_program_name();
 
-  m_log_files.emplace_back(output_folder + "/" + program + "_" + get_log_suffix());
+  // the writer thread isn't running yet, m_file is ours until it starts
+  auto codec = m_file.set_compression(log_compression);
+  m_log_files.emplace_back(output_folder + "/" + program + "_" + get_log_suffix(log_format, codec));
+  m_logging_on = true;
+
+  m_writer_thread = std::thread(&Logger::writer_thread, this);
+  pthread_setname_np(m_writer_thread.native_handle(), "mangohud-logwr");
 
   if(log_interval != 0){
-    std::thread log_thread(&Logger::logging, this);
+    m_log_thread = std::thread(&Logger::logging, this);
     // "mangohud-logging" wouldn't fit in the 15 byte limit
-    pthread_setname_np(log_thread.native_handle(), "mangohud-log");
-    log_thread.detach();
+    pthread_setname_np(m_log_thread.native_handle(), "mangohud-log");
   }
 }
 
 void Logger::stop_logging() {
-  if(!m_logging_on) return;
+  std::lock_guard<std::mutex> lifecycle(m_lifecycle_mtx);
+  // not started or already joined. A log that ran out of log_duration is
+  // finished by its writer thread, only the joins below are left for it.
+  if (!m_writer_thread.joinable()) return;
   m_logging_on = false;
-  m_log_end = Clock::now();
-  if (log_thread.joinable()) log_thread.join();
-
-  calculate_benchmark_data();
-  try {
-      if (output_file.is_open()) {
-          output_file.close();
-      }
-  } catch (...) {
-    SPDLOG_INFO("Something went wrong when closing output_file");
+  {
+    std::lock_guard<std::mutex> lck(m_values_valid_mtx);
+    m_values_valid_cv.notify_all();
   }
-
-  if (!m_log_files.empty())
-    writeSummary(m_log_files.back());
-  else
-    SPDLOG_INFO("Can't write summary because m_log_files is empty");
-
-  clear_log_data();
-#ifdef __linux__
-  control_client_check(get_params()->control, global_control_client, gpu.c_str());
-  const char * cmd = "LoggingFinished";
-  control_send(global_control_client, cmd, strlen(cmd), 0, 0);
-#endif
+  if (m_log_thread.joinable()) m_log_thread.join();
+  m_writer_cv.notify_one();
+  m_writer_thread.join();
 }
 
 void Logger::logging(){
   wait_until_data_valid();
   while (is_active()){
       try_log();
-      this_thread::sleep_for(std::chrono::milliseconds(log_interval));
+      std::unique_lock<std::mutex> lck(m_values_valid_mtx);
+      m_values_valid_cv.wait_for(lck, std::chrono::milliseconds(log_interval), [this] { return !is_active(); });
   }
-  clear_log_data();
 }
 
 void Logger::try_log() {
   if(!is_active()) return;
+  std::unique_lock<std::mutex> consumer(m_consumer_mtx, std::try_to_lock);
+  if (!consumer.owns_lock() || !is_active()) return;
   if(!m_values_valid) return;
   auto now = Clock::now();
   auto elapsedLog = now - m_log_start;
 
-  currentLogData.previous = elapsedLog;
-  currentLogData.fps = fps;
-  currentLogData.frametime = frametime;
-  m_log_array.push_back(currentLogData);
-  writeToFile();
+  m_sample = g_hw_snapshot.log_sample();
+  m_sample.data.previous = elapsedLog;
+  m_sample.data.fps = fps;
+  m_sample.data.frametime = frametime;
+  m_log_summary.add(m_sample.data);
+  if (!m_write_queue.push(m_sample))
+    m_dropped_samples++;
+  else if (m_write_queue.size() >= m_write_queue.capacity() / 2)
+    m_writer_cv.notify_one();
 
   if(log_duration && (elapsedLog >= std::chrono::seconds(log_duration))){
-    stop_logging();
+    // the writer thread closes the file and writes the summary, this may
+    // be the present thread
+    m_logging_on = false;
+    m_writer_cv.notify_one();
   }
 }
 
 void Logger::wait_until_data_valid() {
   std::unique_lock<std::mutex> lck(m_values_valid_mtx);
-  while(! m_values_valid) m_values_valid_cv.wait(lck);
+  while(! m_values_valid && is_active()) m_values_valid_cv.wait(lck);
 }
 
 void Logger::notify_data_valid() {
@@ -358,10 +409,6 @@ void autostart_log(int sleep) {
 }
 
 void Logger::calculate_benchmark_data(){
-  vector<float> fps_values {};
-  for (auto& point : m_log_array)
-    fps_values.push_back(point.frametime);
-
   benchmark.percentile_data.clear();
 
   std::vector<std::string> metrics {"0.97", "avg", "0.01", "0.001"};
@@ -370,7 +417,7 @@ void Logger::calculate_benchmark_data(){
   if (!params->fps_metrics.empty())
     metrics = params->fps_metrics;
     
-  fpsmetrics = std::make_unique<fpsMetrics>(metrics, fps_values);
+  fpsmetrics = std::make_unique<fpsMetrics>(metrics, m_log_summary.frametime.sketch);
   auto metrics_copy = fpsmetrics->copy_metrics();
   for (auto& metric : metrics_copy)
     benchmark.percentile_data.push_back({metric.display_name, metric.value});
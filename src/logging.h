@@ -5,13 +5,22 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <chrono>
 #include <thread>
 #include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <array>
 
 #include "timing.hpp"
 
 #include "overlay_params.h"
+#include "log_schema.h"
+#include "log_binary.h"
+#include "log_file.h"
+#include "spsc_ring.h"
+#include "quantile_sketch.h"
 
 struct logData{
   double fps;
@@ -29,14 +38,58 @@ struct logData{
   float ram_used;
   float swap_used;
   float process_rss;
+  // percent of time some tasks stalled, for the psi graphs
+  float psi_cpu;
+  float psi_memory;
+  float psi_io;
 
   Clock::duration previous;
 };
 
+// One row of the log: the fixed fields and the values of the optional
+// columns selected with log_columns=, in LogSchema's sampler order. The
+// vector is sized once per schema and only reassigned afterwards, so
+// passing samples through the queues doesn't allocate.
+struct logSample {
+  logData data;
+  std::vector<double> extra;
+};
+
+// Sum, peak and distribution of one column of the summary
+struct logSummaryColumn {
+  explicit logSummaryColumn(double max_value) : sketch(0.01, max_value, 0.01) {}
+
+  double total = 0.;
+  float peak = 0.f;
+  quantile_sketch sketch;
+
+  void add(float value);
+  float average(size_t count) const { return count ? total / count : 0.f; }
+};
+
+// Running totals for the summary file, updated for every logged sample so
+// writing the summary doesn't need another pass over the samples
+struct logSummary {
+  size_t count = 0;
+  logSummaryColumn frametime {100000.};
+  logSummaryColumn gpu_load {100.};
+  logSummaryColumn cpu_load {100.};
+  logSummaryColumn gpu_temp {200.};
+  logSummaryColumn cpu_temp {200.};
+  logSummaryColumn vram {1024.};
+  logSummaryColumn ram {4096.};
+  logSummaryColumn swap {4096.};
+
+  void add(const logData& data);
+};
+
 class Logger {
 public:
   Logger(const overlay_params* in_params);
+  ~Logger();
 
+  // Both are serialized. stop_logging() returns once the writer thread
+  // has closed the log and written the summary.
   void start_logging();
   void stop_logging();
   void logging();
@@ -44,17 +97,23 @@ public:
   void try_log();
 
   bool is_active() const { return m_logging_on; }
+  // Columns of the current (or last) log
+  std::shared_ptr<const LogSchema> schema() const { return m_schema.load(); }
 
   void wait_until_data_valid();
   void notify_data_valid();
 
-  auto last_log_end() const noexcept { return m_log_end; }
+  auto last_log_end() const noexcept { return m_log_end.load(); }
   auto last_log_begin() const noexcept { return m_log_start; }
 
-  const std::vector<logData>& get_log_data() const noexcept { return m_log_array; }
-  void clear_log_data() noexcept { m_log_array.clear(); }
+  const logSummary& get_log_summary() const noexcept { return m_log_summary; }
+  void clear_log_data() { m_log_summary = logSummary(); }
+
+  void writeToFile(const logSample& sample);
+  void flushFile();
 
-  void writeToFile();
+  // samples that didn't fit in the write queue during the current/last log
+  uint64_t dropped_samples() const noexcept { return m_dropped_samples; }
 
   void upload_last_log();
   void upload_last_logs();
@@ -62,18 +121,48 @@ public:
   std::string output_folder;
   const int64_t log_interval;
   const int64_t log_duration;
+  const enum log_format log_format;
+  const std::vector<std::string> log_columns;
+  const struct log_compression log_compression;
   bool autostart_init = false;
 
 private:
-  std::vector<logData> m_log_array;
+  logSummary m_log_summary;
   std::vector<std::string> m_log_files;
+  // only used from the writer thread while logging
+  LogFile m_file;
+  BinaryLogWriter m_binary_file;
+  std::ostringstream m_csv_buffer;
+  std::atomic<std::shared_ptr<const LogSchema>> m_schema;
   Clock::time_point m_log_start;
-  Clock::time_point m_log_end;
-  bool m_logging_on;
+  // set by the writer thread after the benchmark data and summary
+  std::atomic<Clock::time_point> m_log_end;
+  std::atomic<bool> m_logging_on;
+  // Held by start_logging() and stop_logging(). A log is only over once
+  // its log and writer threads are joined, m_logging_on is cleared before.
+  std::mutex m_lifecycle_mtx;
+  // calls try_log() every log_interval, never stops the log itself
+  std::thread m_log_thread;
+  // Held by try_log() so only one thread consumes log_sample(), feeds the
+  // summary and pushes to the write queue, and by finish_log() so none does
+  // while the summary is written
+  std::mutex m_consumer_mtx;
+
+  // try_log() runs on the present thread (or the log thread), all disk I/O
+  // happens on the writer thread which drains this queue in batches
+  void writer_thread();
+  void finish_log();
+  spsc_ring<logSample> m_write_queue;
+  // try_log()'s copy of the latest sample, keeps its capacity
+  logSample m_sample;
+  std::thread m_writer_thread;
+  std::mutex m_writer_mtx;
+  std::condition_variable m_writer_cv;
+  std::atomic<uint64_t> m_dropped_samples;
 
   std::mutex m_values_valid_mtx;
   std::condition_variable m_values_valid_cv;
-  bool m_values_valid;
+  std::atomic<bool> m_values_valid;
 };
 
 extern std::shared_ptr<Logger> logger;
@@ -82,7 +171,6 @@ extern std::string os, cpu, gpu, ram, kernel, driver, cpusched;
 extern bool sysInfoFetched;
 extern double fps;
 extern float frametime;
-extern logData currentLogData;
 
 std::string exec(std::string command);
 void autostart_log(int sleep);
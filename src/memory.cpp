@@ -1,6 +1,6 @@
 #include <array>
+#include <atomic>
 #include <fstream>
-#include <map>
 #include <spdlog/spdlog.h>
 #include <string>
 #include <unistd.h>
@@ -9,34 +9,86 @@
 #include "memory.h"
 #include "file_utils.h"
 #include "hud_elements.h"
+#include "process_tree.h"
 
-float memused, memmax, swapused;
 int mem_temp;
 uint64_t proc_mem_resident, proc_mem_shared, proc_mem_virt;
 
-void update_meminfo() {
-    std::ifstream file("/proc/meminfo");
-    std::map<std::string, float> meminfo;
+static constexpr std::array<std::string_view, MEMINFO_KEY_COUNT> meminfo_keys = {
+    "MemTotal", "MemAvailable", "SwapTotal", "SwapFree", "Dirty", "Writeback",
+    "Shmem", "HugePages_Total", "HugePages_Free",
+};
+
+// Perfect hash over meminfo_keys, a line's key only has to be compared
+// against the one entry in its slot. Checked at compile time below, tweak
+// it if a new key collides.
+static constexpr size_t meminfo_table_size = 16;
+static constexpr size_t meminfo_hash(std::string_view key) {
+    return (key.size() + key.front() + 3 * key.back()) % meminfo_table_size;
+}
+
+static constexpr auto meminfo_table = [] {
+    std::array<int8_t, meminfo_table_size> table {};
+    for (auto& slot : table)
+        slot = -1;
+    for (size_t i = 0; i < meminfo_keys.size(); i++)
+        table[meminfo_hash(meminfo_keys[i])] = i;
+    return table;
+}();
+
+static constexpr bool meminfo_table_is_perfect() {
+    for (size_t i = 0; i < meminfo_keys.size(); i++)
+        if (meminfo_table[meminfo_hash(meminfo_keys[i])] != int8_t(i))
+            return false;
+    return true;
+}
+static_assert(meminfo_table_is_perfect(), "meminfo_hash collides, pick another one");
+
+bool parse_meminfo(std::string_view contents, uint32_t wanted, meminfo_snapshot& out) {
+    uint32_t missing = wanted & MEMINFO_ALL_KEYS;
+    while (missing && !contents.empty()) {
+        auto line = next_line(contents);
+        auto sep = line.find(':');
+        if (sep == 0 || sep == std::string_view::npos)
+            continue;
+
+        auto key = line.substr(0, sep);
+        int index = meminfo_table[meminfo_hash(key)];
+        if (index < 0 || !(missing & (1u << index)) || meminfo_keys[index] != key)
+            continue;
+
+        auto val = line.substr(sep + 1);
+        if (scan_u64(val, out.values[index]))
+            missing &= ~(1u << index);
+    }
+    return !missing;
+}
+
+static std::atomic<std::shared_ptr<const meminfo_snapshot>> meminfo_current {
+    std::make_shared<const meminfo_snapshot>()
+};
+
+std::shared_ptr<const meminfo_snapshot> get_meminfo() {
+    return meminfo_current.load();
+}
+
+void update_meminfo(uint32_t wanted) {
+    static persistent_file file("/proc/meminfo");
 
     if (!file.is_open()) {
         SPDLOG_ERROR("can't open /proc/meminfo");
         return;
     }
 
-    for (std::string line; std::getline(file, line);) {
-        auto key = line.substr(0, line.find(":"));
-        auto val = line.substr(key.length() + 2);
-        meminfo[key] = std::stoull(val) / 1024.f / 1024.f;
-    }
-
-    memmax = meminfo["MemTotal"];
-    memused = meminfo["MemTotal"] - meminfo["MemAvailable"];
-    swapused = meminfo["SwapTotal"] - meminfo["SwapFree"];
+    auto snapshot = std::make_shared<meminfo_snapshot>();
+    if (!parse_meminfo(file.read(), wanted, *snapshot))
+        SPDLOG_DEBUG("/proc/meminfo is missing some keys");
+    meminfo_current.store(std::move(snapshot));
 }
 
 void update_mem_temp() {
     static bool inited = false;
-    static std::vector<std::ifstream> mem_temp_files;
+    static std::vector<persistent_file> mem_temp_files;
 
     if (!inited) {
         inited = true;
@@ -52,53 +104,41 @@ void update_mem_temp() {
 
     int temp = 0;
     for (auto &file : mem_temp_files) {
-        int _temp;
-        file.clear();
-        file.seekg(0);
-        if ((file >> _temp) && _temp > temp)
+        int64_t _temp;
+        auto contents = file.read();
+        if (scan_i64(contents, _temp) && _temp > temp)
             temp = _temp;
     }
     mem_temp = temp / 1000;
 }
 
+// Sums statm over the game's process tree. Shared pages are counted once
+// per process that maps them, the same as adding up top's SHR column.
 void update_procmem()
 {
-    auto page_size = sysconf(_SC_PAGESIZE);
-    if (page_size < 0) page_size = 4096;
-
-    std::string f = "/proc/";
-
-    {
-        auto gs_pid = HUDElements.g_gamescopePid;
-        f += gs_pid < 1 ? "self" : std::to_string(gs_pid);
-        f += "/statm";
-    }
-
-    std::ifstream file(f);
-
-    if (!file.is_open()) {
-        SPDLOG_ERROR("can't open {}", f);
-        return;
-    }
-
-    size_t last_idx = 0;
-    std::string line;
-    std::getline(file, line);
-
-    if (line.empty())
-        return;
-
-    std::array<uint64_t, 3> meminfo;
-
-    for (auto i = 0; i < 3; i++) {
-        auto idx = line.find(" ", last_idx);
-        auto val = line.substr(last_idx, idx);
-
-        meminfo[i] = std::stoull(val) * page_size;
-        last_idx = idx + 1;
+    static const auto page_size = [] {
+        auto size = sysconf(_SC_PAGESIZE);
+        return size < 0 ? 4096 : size;
+    }();
+
+    g_process_tree.update(HUDElements.g_gamescopePid);
+
+    std::array<uint64_t, 3> total {};
+    for (auto& m : g_process_tree.members()) {
+        auto line = m.statm.read();
+        std::array<uint64_t, 3> meminfo;
+        bool valid = true;
+        for (auto& val : meminfo)
+            valid = valid && scan_u64(line, val);
+        // exited since the last refresh
+        if (!valid)
+            continue;
+
+        for (size_t i = 0; i < total.size(); i++)
+            total[i] += meminfo[i] * page_size;
     }
 
-    proc_mem_virt = meminfo[0];
-    proc_mem_resident = meminfo[1];
-    proc_mem_shared = meminfo[2];
+    proc_mem_virt = total[0];
+    proc_mem_resident = total[1];
+    proc_mem_shared = total[2];
 }
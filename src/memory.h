@@ -2,13 +2,53 @@
 #ifndef MANGOHUD_MEMORY_H
 #define MANGOHUD_MEMORY_H
 
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <string_view>
+
+// /proc/meminfo keys that are parsed, add the name to meminfo_keys too
+enum meminfo_key {
+    MEMINFO_MEM_TOTAL,
+    MEMINFO_MEM_AVAILABLE,
+    MEMINFO_SWAP_TOTAL,
+    MEMINFO_SWAP_FREE,
+    MEMINFO_DIRTY,
+    MEMINFO_WRITEBACK,
+    MEMINFO_SHMEM,
+    MEMINFO_HUGEPAGES_TOTAL,
+    MEMINFO_HUGEPAGES_FREE,
+    MEMINFO_KEY_COUNT
+};
+
+constexpr uint32_t meminfo_mask(meminfo_key key) { return 1u << key; }
+// What the ram and swap elements need
+constexpr uint32_t MEMINFO_BASIC_KEYS = meminfo_mask(MEMINFO_MEM_TOTAL) | meminfo_mask(MEMINFO_MEM_AVAILABLE) |
+                                        meminfo_mask(MEMINFO_SWAP_TOTAL) | meminfo_mask(MEMINFO_SWAP_FREE);
+constexpr uint32_t MEMINFO_ALL_KEYS = (1u << MEMINFO_KEY_COUNT) - 1;
+
+struct meminfo_snapshot {
+    // kB, except HugePages_* which are page counts
+    std::array<uint64_t, MEMINFO_KEY_COUNT> values {};
+
+    // GiB
+    float total() const { return values[MEMINFO_MEM_TOTAL] / 1024.f / 1024.f; }
+    float used() const { return (values[MEMINFO_MEM_TOTAL] - values[MEMINFO_MEM_AVAILABLE]) / 1024.f / 1024.f; }
+    float swap_used() const { return (values[MEMINFO_SWAP_TOTAL] - values[MEMINFO_SWAP_FREE]) / 1024.f / 1024.f; }
+    // MiB
+    float mib(meminfo_key key) const { return values[key] / 1024.f; }
+};
+
+// Fills the keys in `wanted` from /proc/meminfo contents and stops at the
+// last of them. Returns false if one wasn't found.
+bool parse_meminfo(std::string_view contents, uint32_t wanted, meminfo_snapshot& out);
+// Latest snapshot published by update_meminfo(), never null
+std::shared_ptr<const meminfo_snapshot> get_meminfo();
 
-extern float memused, memmax, swapused;
 extern int mem_temp;
 extern uint64_t proc_mem_resident, proc_mem_shared, proc_mem_virt;
 
-void update_meminfo();
+void update_meminfo(uint32_t wanted = MEMINFO_BASIC_KEYS);
 void update_mem_temp();
 void update_procmem();
 
@@ -1,9 +1,30 @@
 #include "net.h"
 #include "hud_elements.h"
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#endif
 
 Net::Net() {
+    find_interfaces();
+    if (!open_netlink())
+        SPDLOG_DEBUG("Network: netlink stats unavailable, using sysfs");
+}
+
+Net::~Net() {
+    if (m_netlink >= 0)
+        close(m_netlink);
+}
+
+void Net::find_interfaces() {
     auto params = get_params();
     should_reset = false;
+    interfaces.clear();
     fs::path net_dir(NETDIR);
     if (fs::exists(net_dir) && fs::is_directory(net_dir)) {
         for (const auto& entry : fs::directory_iterator(net_dir)) {
@@ -12,60 +33,169 @@ Net::Net() {
                 if (val == "lo")
                     continue;
 
-                if (!params->network.empty() && params->network.front() == "1") {
-                    interfaces.push_back({entry.path().filename().string(), 0, 0});
+                // no selection happens when only the log asks for network columns
+                if (params->network.empty() || params->network.front() == "1") {
+                    interfaces.push_back({val, 0, 0, 0});
                 } else if (!params->network.empty()){
                     auto it = std::find(params->network.begin(), params->network.end(), val);
                     if (it != params->network.end())
-                        interfaces.push_back({entry.path().filename().string(), 0, 0});
+                        interfaces.push_back({val, 0, 0, 0});
                 }
             }
         }
     }
-    
+
+#ifdef __linux__
+    for (auto& iface : interfaces)
+        iface.index = if_nametoindex(iface.name.c_str());
+#endif
+
     if (interfaces.empty())
         SPDLOG_ERROR("Network: couldn't find any interfaces");
 }
 
-long long safe_stoll(const std::string& str, long long default_value);
-long long safe_stoll(const std::string& str, long long default_value = 0) {
-    if (str.empty()) {
-        SPDLOG_DEBUG("tx or rx returned an empty string");
-        return default_value;
+bool Net::open_netlink() {
+#ifdef __linux__
+    m_netlink = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (m_netlink < 0)
+        return false;
+
+    sockaddr_nl addr {};
+    addr.nl_family = AF_NETLINK;
+    if (bind(m_netlink, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(m_netlink);
+        m_netlink = -1;
+        return false;
     }
 
-    try {
-        return std::stoll(str);
-    } catch (const std::invalid_argument& e) {
-        SPDLOG_DEBUG("stoll invalid argument");
-    } catch (const std::out_of_range& e) {
-        SPDLOG_DEBUG("stoll out of range");
+    m_buffer.resize(32 * 1024);
+    // RTM_GETSTATS needs Linux 4.7, find out now instead of on every update
+    if (!read_netlink()) {
+        close(m_netlink);
+        m_netlink = -1;
+        return false;
     }
-    return default_value;
+    return true;
+#else
+    return false;
+#endif
 }
 
-void Net::update() {
-    if (!interfaces.empty()) {
-        for (auto& iface : interfaces) {
-            // path to tx_bytes and rx_bytes
-            std::string txfile = (NETDIR + iface.name + TXFILE);
-            std::string rxfile = (NETDIR + iface.name + RXFILE);
-            
-            // amount of bytes at previous update
-            uint64_t prevTx = iface.txBytes;
-            uint64_t prevRx = iface.rxBytes;
-            
-            // current amount of bytes
-            iface.txBytes = safe_stoll(read_line(txfile));
-            iface.rxBytes = safe_stoll(read_line(rxfile));
-
-            auto now = std::chrono::steady_clock::now();
-            // calculate the bytes per second since last update
-            iface.txBps = calculateThroughput(iface.txBytes, prevTx, iface.previousTime, now);
-            iface.rxBps = calculateThroughput(iface.rxBytes, prevRx, iface.previousTime, now);
-            iface.previousTime = now;
+// Updates the byte counters of all interfaces from one RTM_GETSTATS dump
+bool Net::read_netlink() {
+#ifdef __linux__
+    struct {
+        nlmsghdr header;
+        if_stats_msg stats;
+    } request {};
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = RTM_GETSTATS;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++m_seq;
+    request.stats.family = AF_UNSPEC;
+    request.stats.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    if (send(m_netlink, &request, sizeof(request), 0) < 0)
+        return false;
+
+    while (true) {
+        ssize_t len = recv(m_netlink, m_buffer.data(), m_buffer.size(), 0);
+        if (len < 0)
+            return false;
+
+        for (auto msg = reinterpret_cast<nlmsghdr*>(m_buffer.data()); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_seq != m_seq)
+                continue;
+            if (msg->nlmsg_type == NLMSG_DONE)
+                return true;
+            if (msg->nlmsg_type == NLMSG_ERROR)
+                return false;
+            if (msg->nlmsg_type != RTM_NEWSTATS)
+                continue;
+
+            auto stats = static_cast<if_stats_msg*>(NLMSG_DATA(msg));
+            auto iface = std::find_if(interfaces.begin(), interfaces.end(),
+                                      [&](const networkInterface& i) { return i.index == stats->ifindex; });
+            if (iface == interfaces.end())
+                continue;
+
+            int attr_len = msg->nlmsg_len - NLMSG_LENGTH(sizeof(*stats));
+            auto attr = reinterpret_cast<rtattr*>(reinterpret_cast<char*>(stats) + NLMSG_ALIGN(sizeof(*stats)));
+            for (; RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type != IFLA_STATS_LINK_64)
+                    continue;
+                rtnl_link_stats64 link {};
+                memcpy(&link, RTA_DATA(attr), std::min<size_t>(sizeof(link), RTA_PAYLOAD(attr)));
+                iface->txBytes = link.tx_bytes;
+                iface->rxBytes = link.rx_bytes;
+            }
         }
     }
+#else
+    return false;
+#endif
+}
+
+static uint64_t read_counter(persistent_file& file) {
+    auto contents = file.read();
+    uint64_t value;
+    if (!scan_u64(contents, value)) {
+        SPDLOG_DEBUG("Failed to read counter from {}", file.path());
+        return 0;
+    }
+    return value;
+}
+
+void Net::read_sysfs() {
+    for (auto& iface : interfaces) {
+        // tx_bytes and rx_bytes stay open between updates
+        if (!iface.txFile.is_open())
+            iface.txFile.open(NETDIR + iface.name + TXFILE);
+        if (!iface.rxFile.is_open())
+            iface.rxFile.open(NETDIR + iface.name + RXFILE);
+
+        iface.txBytes = read_counter(iface.txFile);
+        iface.rxBytes = read_counter(iface.rxFile);
+    }
+}
+
+void Net::update() {
+    if (should_reset)
+        find_interfaces();
+
+    if (interfaces.empty())
+        return;
+
+    // amount of bytes at previous update
+    m_previous.clear();
+    for (auto& iface : interfaces)
+        m_previous.emplace_back(iface.txBytes, iface.rxBytes);
+
+    if (m_netlink < 0 || !read_netlink())
+        read_sysfs();
+
+    auto now = std::chrono::steady_clock::now();
+    auto result = std::move(m_spare);
+    if (!result)
+        result = std::make_shared<std::vector<throughputData>>();
+    result->resize(interfaces.size());
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        auto& iface = interfaces[i];
+        // calculate the bytes per second since last update
+        iface.txBps = calculateThroughput(iface.txBytes, m_previous[i].first, iface.previousTime, now);
+        iface.rxBps = calculateThroughput(iface.rxBytes, m_previous[i].second, iface.previousTime, now);
+        iface.previousTime = now;
+        auto& data = (*result)[i];
+        data.name = iface.name;
+        data.txBps = iface.txBps;
+        data.rxBps = iface.rxBps;
+    }
+
+    // Readers take their reference under the atomic's lock, so once the old
+    // snapshot is swapped out a use count of one means nobody else has it
+    auto old = m_throughput.exchange(std::move(result));
+    if (old && old.use_count() == 1)
+        m_spare = std::const_pointer_cast<std::vector<throughputData>>(old);
 }
 
 uint64_t Net::calculateThroughput(long long currentBytes, long long previousBytes,
@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 #include <stdint.h>
+#include <atomic>
+#include <memory>
 #include "filesystem.h"
 #include "file_utils.h"
 #include <spdlog/spdlog.h>
@@ -21,26 +23,57 @@ namespace fs = ghc::filesystem;
 #define RXFILE "/statistics/rx_bytes"
 #endif
 
+// Network throughput of the interfaces selected with network=. update()
+// runs on the hw info thread and fetches the counters of all interfaces
+// with one netlink RTM_GETSTATS dump, falling back to sysfs when netlink
+// stats aren't available. Readers use throughput(), which doesn't lock.
 class Net {
     public:
-        bool should_reset = false;
+        // re-enumerate the interfaces on the next update, e.g. after a config reload
+        std::atomic<bool> should_reset {false};
+
+        struct throughputData {
+            std::string name;
+            uint64_t txBps;
+            uint64_t rxBps;
+        };
+
+        Net();
+        ~Net();
+        void update();
+        std::shared_ptr<const std::vector<throughputData>> throughput() const {
+            return m_throughput.load();
+        }
+
+    private:
         struct networkInterface {
             std::string name;
+            unsigned index;
             uint64_t txBytes;
             uint64_t rxBytes;
             uint64_t txBps;
             uint64_t rxBps;
             std::chrono::steady_clock::time_point previousTime;
+            persistent_file txFile, rxFile;
         };
 
-        Net();
-        void update();
         std::vector<networkInterface> interfaces = {};
+        std::atomic<std::shared_ptr<const std::vector<throughputData>>> m_throughput;
+        // counters at the previous update and the last snapshot no reader
+        // held on to, both reused so polling doesn't allocate
+        std::vector<std::pair<uint64_t, uint64_t>> m_previous;
+        std::shared_ptr<std::vector<throughputData>> m_spare;
+        int m_netlink = -1;
+        uint32_t m_seq = 0;
+        std::vector<char> m_buffer;
 
-    private:
+        void find_interfaces();
+        bool open_netlink();
+        bool read_netlink();
+        void read_sysfs();
         uint64_t calculateThroughput(long long currentBytes, long long previousBytes,
                             std::chrono::steady_clock::time_point previousTime,
                             std::chrono::steady_clock::time_point currentTime);
 };
 
-extern std::unique_ptr<Net> net;
\ No newline at end of file
+extern std::unique_ptr<Net> net;
@@ -67,38 +67,137 @@ NVIDIA::NVIDIA(const char* pciBusId) {
 
     if (nvml_available || nvctrl_available) {
         throttling = std::make_shared<Throttling>(0x10de);
-        thread = std::thread(&NVIDIA::get_samples_and_copy, this);
-        pthread_setname_np(thread.native_handle(), "mangohud-nvidia");
     } else {
         SPDLOG_WARN("NVML and NVCTRL are unavailable. Unable to get NVIDIA info. User is on DFSG version of mangohud?");
     }
 }
 
 #ifdef HAVE_NVML
-void NVIDIA::get_instant_metrics_nvml(struct gpu_metrics *metrics, struct overlay_params *params) {
+static double nvml_sample_value(nvmlValueType_t type, const nvmlValue_t& value) {
+    switch (type) {
+        case NVML_VALUE_TYPE_DOUBLE: return value.dVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG: return value.ulVal;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: return value.ullVal;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG: return value.sllVal;
+        default: return value.uiVal;
+    }
+}
+
+// Forwards what the driver sampled since the previous call to the
+// sampler's windows, each sample at the time it was taken, and sets
+// `latest` to the newest one. Returns false if the counter isn't sampled
+// on this GPU or the call failed, the caller queries it directly then.
+// When nothing new was sampled `latest` keeps its previous value.
+bool NVIDIA::nvml_take_samples(nvml_sample_buffer& buf, gpu_window_field field, float scale, float& latest) {
+    if (!buf.supported)
+        return false;
+
+    nvmlValueType_t type;
+    unsigned int count = 0;
+    nvmlReturn_t ret;
+
+    if (buf.samples.empty()) {
+        // Without a buffer NVML returns how many samples it keeps
+        ret = nvml->nvmlDeviceGetSamples(device, buf.type, 0, &type, &count, nullptr);
+        if (ret == NVML_ERROR_NOT_SUPPORTED || (ret == NVML_SUCCESS && count == 0)) {
+            SPDLOG_DEBUG("nvmlDeviceGetSamples({}) unavailable: {}", int(buf.type), nvml->nvmlErrorString(ret));
+            buf.supported = false;
+            return false;
+        }
+        if (ret != NVML_SUCCESS)
+            return false;
+        buf.samples.resize(count);
+    }
+
+    count = buf.samples.size();
+    ret = nvml->nvmlDeviceGetSamples(device, buf.type, buf.last_seen, &type, &count, buf.samples.data());
+    // The driver keeps more samples than it first reported, grow and ask again
+    for (int tries = 0; ret == NVML_ERROR_INSUFFICIENT_SIZE && tries < 4; tries++) {
+        buf.samples.resize(std::max<size_t>(count, buf.samples.size() * 2));
+        count = buf.samples.size();
+        ret = nvml->nvmlDeviceGetSamples(device, buf.type, buf.last_seen, &type, &count, buf.samples.data());
+    }
+    if (ret == NVML_ERROR_NOT_FOUND) {
+        // nothing new, the windows just keep what they have
+        nvml_batch.fields |= 1u << field;
+        return true;
+    }
+    if (ret == NVML_ERROR_NOT_SUPPORTED) {
+        SPDLOG_DEBUG("nvmlDeviceGetSamples({}) unavailable: {}", int(buf.type), nvml->nvmlErrorString(ret));
+        buf.supported = false;
+        return false;
+    }
+    if (ret != NVML_SUCCESS) {
+        // queried directly for this window only, samples are tried again next time
+        SPDLOG_DEBUG("nvmlDeviceGetSamples({}) failed: {}", int(buf.type), nvml->nvmlErrorString(ret));
+        return false;
+    }
+
+    // The buffer is a ring, put the new samples back in order
+    auto first = buf.samples.begin(), last = buf.samples.begin() + count;
+    if (buf.last_seen)
+        last = std::remove_if(first, last, [&](const nvmlSample_t& s) { return s.timeStamp <= buf.last_seen; });
+    std::sort(first, last, [](const nvmlSample_t& a, const nvmlSample_t& b) { return a.timeStamp < b.timeStamp; });
+    if (first == last) {
+        nvml_batch.fields |= 1u << field;
+        return true;
+    }
+
+    // The first call returns the driver's whole history, start the windows
+    // at its newest sample
+    if (buf.last_seen == 0)
+        first = last - 1;
+
+    // Timestamps are the driver's wall clock in us, the windows run on
+    // steady_clock
+    using namespace std::chrono;
+    auto steady_now = steady_clock::now();
+    unsigned long long wall_now = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    for (auto it = first; it != last; ++it) {
+        auto age = microseconds(wall_now > it->timeStamp ? wall_now - it->timeStamp : 0);
+        float value = nvml_sample_value(type, it->sampleValue) * scale;
+        nvml_batch.add(field, steady_now - age, value);
+        latest = value;
+    }
+    buf.last_seen = (last - 1)->timeStamp;
+    return true;
+}
+
+void NVIDIA::take_samples(gpu_sample_batch& batch) {
+    std::swap(batch, nvml_batch);
+}
+
+// Called once per METRICS_UPDATE_PERIOD_MS. Load, power and clocks come
+// from the driver's sample buffer, every sample goes to the windows through
+// take_samples(). The rest is read once.
+void NVIDIA::get_window_metrics_nvml(struct gpu_metrics *metrics, struct overlay_params *params) {
     nvmlReturn_t response;
 
     if (nvml && nvml_available) {
         nvml_get_process_info();
+        bool logging = logger && logger->is_active();
 
-        struct nvmlUtilization_st nvml_utilization;
-        response = nvml->nvmlDeviceGetUtilizationRates(device, &nvml_utilization);
-        if (response == NVML_ERROR_NOT_SUPPORTED) {
-            SPDLOG_ERROR("nvmlDeviceGetUtilizationRates failed, disabling nvml metrics");
+        float load = metrics->load;
+        if (!nvml_take_samples(util_samples, GPU_FIELD_LOAD, 1, load)) {
+            struct nvmlUtilization_st nvml_utilization;
+            response = nvml->nvmlDeviceGetUtilizationRates(device, &nvml_utilization);
+            if (response == NVML_ERROR_NOT_SUPPORTED) {
+                SPDLOG_ERROR("nvmlDeviceGetUtilizationRates failed, disabling nvml metrics");
 
-            nvml_available = false;
-            return;
+                nvml_available = false;
+                return;
+            }
+            load = nvml_utilization.gpu;
         }
+        metrics->load = load;
 
-        metrics->load = nvml_utilization.gpu;
-
-        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_temp] || (logger && logger->is_active())) {
+        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_temp] || logging) {
             unsigned int temp;
             nvml->nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &temp);
             metrics->temp = temp;
         }
 
-        if (params->enabled[OVERLAY_PARAM_ENABLED_vram] || (logger && logger->is_active())) {
+        if (params->enabled[OVERLAY_PARAM_ENABLED_vram] || logging) {
             struct nvmlMemory_st nvml_memory;
             nvml->nvmlDeviceGetMemoryInfo(device, &nvml_memory);
             metrics->memoryTotal = nvml_memory.total / (1024.f * 1024.f * 1024.f);
@@ -108,24 +207,42 @@ void NVIDIA::get_instant_metrics_nvml(struct gpu_metrics *metrics, struct overla
         if (params->enabled[OVERLAY_PARAM_ENABLED_proc_vram])
             metrics->proc_vram_used = get_proc_vram() / (1024.f * 1024.f * 1024.f);
 
-        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_core_clock] || (logger && logger->is_active())) {
-            unsigned int core_clock;
-            nvml->nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &core_clock);
+        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_core_clock] || logging) {
+            float core_clock = metrics->CoreClock;
+            if (!nvml_take_samples(core_clock_samples, GPU_FIELD_CORE_CLOCK, 1, core_clock)) {
+                unsigned int clock;
+                nvml->nvmlDeviceGetClockInfo(device, NVML_CLOCK_GRAPHICS, &clock);
+                core_clock = clock;
+            }
             metrics->CoreClock = core_clock;
         }
 
-        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_mem_clock] || (logger && logger->is_active())) {
-            unsigned int memory_clock;
-            nvml->nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &memory_clock);
+        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_mem_clock] || logging) {
+            float memory_clock = metrics->MemClock;
+            if (!nvml_take_samples(mem_clock_samples, GPU_FIELD_MEM_CLOCK, 1, memory_clock)) {
+                unsigned int clock;
+                nvml->nvmlDeviceGetClockInfo(device, NVML_CLOCK_MEM, &clock);
+                memory_clock = clock;
+            }
             metrics->MemClock = memory_clock;
         }
 
-        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_power] || (logger && logger->is_active())) {
-            unsigned int power, limit;
-            nvml->nvmlDeviceGetPowerUsage(device, &power);
-            nvml->nvmlDeviceGetPowerManagementLimit(device, &limit);
-            metrics->powerUsage = power / 1000;
-            metrics->powerLimit = limit / 1000;
+        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_power] || logging) {
+            float power = metrics->powerUsage;
+            if (!nvml_take_samples(power_samples, GPU_FIELD_POWER, 1 / 1000.f, power)) {
+                unsigned int mw;
+                nvml->nvmlDeviceGetPowerUsage(device, &mw);
+                power = mw / 1000.f;
+            }
+            metrics->powerUsage = power;
+
+            // Only changes when the user sets it, every ~10s is plenty
+            if (power_limit_age-- == 0) {
+                unsigned int limit;
+                nvml->nvmlDeviceGetPowerManagementLimit(device, &limit);
+                metrics->powerLimit = limit / 1000;
+                power_limit_age = 10000 / METRICS_UPDATE_PERIOD_MS;
+            }
         }
 
         if (params->enabled[OVERLAY_PARAM_ENABLED_throttling_status]) {
@@ -138,7 +255,7 @@ void NVIDIA::get_instant_metrics_nvml(struct gpu_metrics *metrics, struct overla
 		        throttling->indep_throttle_status = nvml_throttle_reasons;
         }
 
-        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_fan] || (logger && logger->is_active())){
+        if (params->enabled[OVERLAY_PARAM_ENABLED_gpu_fan] || logging){
             unsigned int fan_speed;
             nvml->nvmlDeviceGetFanSpeed(device, &fan_speed);
             metrics->fan_speed = fan_speed;
@@ -217,58 +334,44 @@ void NVIDIA::get_instant_metrics_xnvctrl(struct gpu_metrics *metrics) {
         metrics->sys_vram_used = static_cast<float>(memused) / 1024.f;
 
         metrics->fan_speed = NVIDIA::get_nvctrl_fan_speed();
+        metrics->fan_rpm = true;
     }
 }
 #endif
 
-void NVIDIA::get_samples_and_copy() {
-    struct gpu_metrics metrics_buffer[METRICS_SAMPLE_COUNT] {};
-    auto logger_ref = logger; // inc ref count, to avoid destruction of logger.
-    while(!stop_thread) {
-        auto params = get_params();
-        auto params_p = params.get(); // avoid destruction while we are getting samples...
+unsigned NVIDIA::sample_period_ms() const {
+#ifdef HAVE_NVML
+    // The driver samples on its own, so there is nothing to poll in
+    // between. Pull its buffer once per window.
+    if (nvml_available)
+        return METRICS_UPDATE_PERIOD_MS;
+#endif
+#ifndef TEST_ONLY
+    return get_params()->gpu_sample_period;
+#else
+    return METRICS_POLLING_PERIOD_MS;
+#endif
+}
 
+void NVIDIA::update(gpu_metrics& metrics) {
+    (void)metrics;
 #ifndef TEST_ONLY
-        if (HUDElements.g_gamescopePid > 0 && HUDElements.g_gamescopePid != pid) {
-            pid = HUDElements.g_gamescopePid;
-        }
+    if (HUDElements.g_gamescopePid > 0 && HUDElements.g_gamescopePid != pid) {
+        pid = HUDElements.g_gamescopePid;
+    }
 #endif
+}
 
-        for (size_t cur_sample_id=0; cur_sample_id < METRICS_SAMPLE_COUNT; cur_sample_id++) {
+void NVIDIA::sample(gpu_metrics& metrics) {
+    auto params = get_params();
 #ifdef HAVE_NVML
-        if (nvml_available)
-            NVIDIA::get_instant_metrics_nvml(&metrics_buffer[cur_sample_id], params_p);
+    if (nvml_available)
+        NVIDIA::get_window_metrics_nvml(&metrics, params.get());
 #endif
 #if defined(HAVE_XNVCTRL) && defined(HAVE_X11)
-        if (nvctrl_available)
-            NVIDIA::get_instant_metrics_xnvctrl(&metrics_buffer[cur_sample_id]);
+    if (nvctrl_available)
+        NVIDIA::get_instant_metrics_xnvctrl(&metrics);
 #endif
-            usleep(METRICS_POLLING_PERIOD_MS * 1000);
-        }
-
-        if (stop_thread) break;
-
-        std::unique_lock<std::mutex> lock(metrics_mutex);
-        cond_var.wait(lock, [this]() { return !paused || stop_thread; });
-        GPU_UPDATE_METRIC_AVERAGE(load);
-        GPU_UPDATE_METRIC_AVERAGE_FLOAT(powerUsage);
-        GPU_UPDATE_METRIC_MAX(powerLimit);
-        GPU_UPDATE_METRIC_AVERAGE(CoreClock);
-        GPU_UPDATE_METRIC_AVERAGE(MemClock);
-
-        GPU_UPDATE_METRIC_AVERAGE(temp);
-
-        GPU_UPDATE_METRIC_AVERAGE_FLOAT(memoryTotal);
-        GPU_UPDATE_METRIC_AVERAGE_FLOAT(sys_vram_used);
-        GPU_UPDATE_METRIC_AVERAGE_FLOAT(proc_vram_used);
-
-        GPU_UPDATE_METRIC_MAX(is_power_throttled);
-        GPU_UPDATE_METRIC_MAX(is_current_throttled);
-        GPU_UPDATE_METRIC_MAX(is_temp_throttled);
-        GPU_UPDATE_METRIC_MAX(is_other_throttled);
-
-        GPU_UPDATE_METRIC_MAX(fan_speed);
-    }
 }
 
 #if defined(HAVE_XNVCTRL) && defined(HAVE_X11)
@@ -282,7 +385,6 @@ int64_t NVIDIA::get_nvctrl_fan_speed(){
                             NV_CTRL_THERMAL_COOLER_SPEED,
                             &fan_speed);
     }
-    metrics.fan_rpm = true;
     return fan_speed;
 }
 #endif
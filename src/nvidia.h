@@ -8,26 +8,34 @@
 #include "loaders/loader_x11.h"
 #endif
 
-class NVIDIA {
+#ifdef HAVE_NVML
+// The driver keeps its own high-rate buffer of some counters, this pulls
+// the samples newer than last_seen out of it in one call
+struct nvml_sample_buffer {
+    explicit nvml_sample_buffer(nvmlSamplingType_t type) : type(type) {}
+
+    nvmlSamplingType_t type;
+    unsigned long long last_seen = 0; // us, driver's cpu timestamp
+    std::vector<nvmlSample_t> samples;
+    bool supported = true;
+};
+#endif
+
+class NVIDIA : public GpuSource {
     public:
         std::shared_ptr<Throttling> throttling;
 
         bool nvml_available = false;
         bool nvctrl_available = false;
 
-        gpu_metrics copy_metrics() {
-            std::lock_guard<std::mutex> lock(metrics_mutex);
-            return metrics;
-        };
-
-        void get_samples_and_copy();
-
         NVIDIA(const char* pciBusId);
-        ~NVIDIA() {
-            stop_thread = true;
-            if (thread.joinable())
-                thread.join();
-        };
+
+        unsigned sample_period_ms() const override;
+        void sample(gpu_metrics& metrics) override;
+        void update(gpu_metrics& metrics) override;
+#ifdef HAVE_NVML
+        void take_samples(gpu_sample_batch& batch) override;
+#endif
 
 #ifdef HAVE_NVML
         void nvml_get_process_info() {
@@ -72,31 +80,25 @@ class NVIDIA {
         };
 #endif        
 
-        void pause() {
-            paused = true;
-            cond_var.notify_one();
-        };
-
-        void resume() {
-            paused = false;
-            cond_var.notify_one();
-        }
-
     private:
         pid_t pid = getpid();
-        std::mutex metrics_mutex;
-        gpu_metrics metrics;
-        std::thread thread;
-        std::condition_variable cond_var;
-        std::atomic<bool> stop_thread{false};
-        std::atomic<bool> paused{false};
 
 #ifdef HAVE_NVML
         nvmlDevice_t device;
 
         std::vector<nvmlProcessInfo_v1_t> process_info = {};
 
-        void get_instant_metrics_nvml(struct gpu_metrics *metrics, struct overlay_params *params);
+        nvml_sample_buffer util_samples {NVML_GPU_UTILIZATION_SAMPLES};
+        nvml_sample_buffer power_samples {NVML_TOTAL_POWER_SAMPLES};
+        nvml_sample_buffer core_clock_samples {NVML_PROCESSOR_CLK_SAMPLES};
+        nvml_sample_buffer mem_clock_samples {NVML_MEMORY_CLK_SAMPLES};
+        // what the sample buffers returned since the last take_samples()
+        gpu_sample_batch nvml_batch;
+        // windows until the power limit is read again
+        unsigned power_limit_age = 0;
+
+        bool nvml_take_samples(nvml_sample_buffer& buf, gpu_window_field field, float scale, float& latest);
+        void get_window_metrics_nvml(struct gpu_metrics *metrics, struct overlay_params *params);
         std::shared_ptr<libnvml_loader> nvml = get_libnvml_loader();
 #endif
 
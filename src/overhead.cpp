@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+#include "overhead.h"
+#include "mesa/util/os_time.h"
+
+Overhead g_overhead;
+
+size_t Overhead::stage(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_register_mtx);
+  size_t count = m_stage_count.load();
+  for (size_t i = 0; i < count; i++)
+    if (m_stages[i].name == name)
+      return i;
+
+  if (count == max_stages) {
+    SPDLOG_WARN("Too many overhead stages, not tracking '{}'", name);
+    return max_stages;
+  }
+
+  m_stages[count].name = name;
+  m_stage_count.store(count + 1);
+  return count;
+}
+
+size_t Overhead::bucket(double us) {
+  if (!(us > histogram_min_us))
+    return 0;
+  size_t i = std::log(us / histogram_min_us) / std::log(histogram_growth);
+  return std::min(i, histogram_buckets - 1);
+}
+
+// Geometric middle of a bucket
+double Overhead::bucket_value(size_t bucket) {
+  return histogram_min_us * std::pow(histogram_growth, bucket + 0.5);
+}
+
+void Overhead::record(size_t id, uint64_t elapsed_ns) {
+  if (id >= m_stage_count.load(std::memory_order_acquire))
+    return;
+
+  auto& s = m_stages[id];
+  s.histogram[bucket(elapsed_ns / 1000.)].fetch_add(1, std::memory_order_relaxed);
+  s.total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+  uint64_t max = s.max_ns.load(std::memory_order_relaxed);
+  while (elapsed_ns > max && !s.max_ns.compare_exchange_weak(max, elapsed_ns, std::memory_order_relaxed))
+    ;
+}
+
+void Overhead::roll() {
+  uint64_t now = os_time_get_nano();
+  uint64_t window = m_window_start ? now - m_window_start : 0;
+  m_window_start = now;
+
+  auto summary = std::make_shared<std::vector<overhead_summary>>();
+  float total_load = 0.f;
+  size_t count = m_stage_count.load(std::memory_order_acquire);
+  std::array<uint32_t, histogram_buckets> histogram;
+  for (size_t i = 0; i < count; i++) {
+    auto& s = m_stages[i];
+    // A call recorded while this runs may be split between two windows,
+    // that doesn't matter for a summary
+    uint64_t calls = 0;
+    for (size_t b = 0; b < histogram_buckets; b++) {
+      histogram[b] = s.histogram[b].exchange(0, std::memory_order_relaxed);
+      calls += histogram[b];
+    }
+    uint64_t total_ns = s.total_ns.exchange(0, std::memory_order_relaxed);
+    float max_us = s.max_ns.exchange(0, std::memory_order_relaxed) / 1000.f;
+
+    float p99_us = 0.f;
+    uint64_t above = calls / 100, seen = 0;
+    for (size_t b = histogram_buckets; calls && b-- > 0;) {
+      seen += histogram[b];
+      if (seen > above) {
+        p99_us = std::min<float>(bucket_value(b), max_us);
+        break;
+      }
+    }
+
+    float load = window ? 100.f * total_ns / window : 0.f;
+    float avg_us = calls ? total_ns / 1000.f / calls : 0.f;
+    summary->push_back({s.name, calls, avg_us, p99_us, max_us, load});
+    total_load += load;
+  }
+
+  m_summary.store(std::move(summary));
+  m_total_load.store(total_load);
+}
+
+ScopedOverhead::ScopedOverhead(size_t stage)
+  : m_stage(stage), m_start(os_time_get_nano()) {}
+
+ScopedOverhead::~ScopedOverhead() {
+  g_overhead.record(m_stage, os_time_get_nano() - m_start);
+}
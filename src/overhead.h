@@ -0,0 +1,86 @@
+#pragma once
+#ifndef MANGOHUD_OVERHEAD_H
+#define MANGOHUD_OVERHEAD_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Self-profiling of the work MangoHud does on behalf of the app.
+ *
+ * Each poller and render stage records how long it took into a per-stage
+ * histogram of relaxed atomic counters, so the render thread never waits on
+ * the hw thread. Once per window roll() takes the histograms over and turns
+ * them into a summary that the mangohud_overhead HUD element and the
+ * overhead log columns read.
+ */
+
+struct overhead_summary {
+  std::string name;
+  uint64_t calls;
+  float avg_us;
+  float p99_us;
+  float max_us;
+  float load;      // percent of one core
+};
+
+class Overhead {
+public:
+  static constexpr size_t max_stages = 32;
+  // 5% wide buckets from 0.1 us to 1 s
+  static constexpr double histogram_min_us = 0.1;
+  static constexpr double histogram_growth = 1.05;
+  static constexpr size_t histogram_buckets = 331;
+
+  // Returns the id of the named stage, registering it on first use
+  size_t stage(const std::string& name);
+  void record(size_t id, uint64_t elapsed_ns);
+  // Publishes the stats gathered since the previous call
+  void roll();
+
+  std::shared_ptr<const std::vector<overhead_summary>> summary() const {
+    return m_summary.load();
+  }
+  // percent of one core spent in all stages during the last window
+  float total_load() const { return m_total_load.load(); }
+
+private:
+  struct stage_data {
+    std::string name;
+    std::array<std::atomic<uint32_t>, histogram_buckets> histogram {};
+    std::atomic<uint64_t> total_ns {0};
+    std::atomic<uint64_t> max_ns {0};
+  };
+
+  static size_t bucket(double us);
+  static double bucket_value(size_t bucket);
+
+  std::mutex m_register_mtx;
+  std::array<stage_data, max_stages> m_stages;
+  std::atomic<size_t> m_stage_count {0};
+  uint64_t m_window_start = 0;
+  std::atomic<std::shared_ptr<const std::vector<overhead_summary>>> m_summary;
+  std::atomic<float> m_total_load {0.f};
+};
+
+extern Overhead g_overhead;
+
+class ScopedOverhead {
+public:
+  explicit ScopedOverhead(size_t stage);
+  ~ScopedOverhead();
+
+  ScopedOverhead(const ScopedOverhead&) = delete;
+  ScopedOverhead& operator=(const ScopedOverhead&) = delete;
+
+private:
+  size_t m_stage;
+  uint64_t m_start;
+};
+
+#endif //MANGOHUD_OVERHEAD_H
@@ -26,8 +26,12 @@
 #include "amdgpu.h"
 #include "fps_metrics.h"
 #include "net.h"
+#include "pressure.h"
+#include "thread_stats.h"
 #include "fex.h"
 #include "ftrace.h"
+#include "timer_wheel.h"
+#include "overhead.h"
 
 #ifdef __linux__
 #include <libgen.h>
@@ -43,7 +47,6 @@ bool gui_open = false;
 bool fcat_open = false;
 struct benchmark_stats benchmark;
 ImVec2 real_font_size;
-std::deque<logData> graph_data;
 overlay_params *_params {};
 double min_frametime, max_frametime;
 bool gpu_metrics_exists = false;
@@ -99,83 +102,106 @@ void init_spdlog()
 
 }
 
-void update_hw_info(const struct overlay_params& params, uint32_t vendorID)
+// Only poll the sources that the columns of the running log need
+static bool log_wants(const std::shared_ptr<const LogSchema>& schema, log_source source)
 {
-   auto real_params = get_params();
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_fan])
-      update_fan();
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_cpu_stats] || logger->is_active()) {
-      cpuStats.UpdateCPUData();
+   return schema && schema->wants(source);
+}
 
-#ifdef __linux__
-      if (real_params->enabled[OVERLAY_PARAM_ENABLED_core_load] || real_params->enabled[OVERLAY_PARAM_ENABLED_cpu_mhz] || logger->is_active())
-         cpuStats.UpdateCoreMhz();
-      if (real_params->enabled[OVERLAY_PARAM_ENABLED_cpu_temp] || logger->is_active() || real_params->enabled[OVERLAY_PARAM_ENABLED_graphs])
-         cpuStats.UpdateCpuTemp();
-      if (real_params->enabled[OVERLAY_PARAM_ENABLED_cpu_power] || logger->is_active())
-         cpuStats.UpdateCpuPower();
-#endif
-   }
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_gpu_stats] || logger->is_active()) {
-      if (gpus)
-         gpus->get_metrics();
+static void publish_hw_info(const std::shared_ptr<const LogSchema>& log_schema)
+{
+   auto& snapshot = g_hw_snapshot.staging();
+   auto& data = snapshot.data;
+   if (gpus && gpus->active_gpu()) {
+      data.gpu_load = gpus->active_gpu()->metrics.load;
+      data.gpu_temp = gpus->active_gpu()->metrics.temp;
+      data.gpu_core_clock = gpus->active_gpu()->metrics.CoreClock;
+      data.gpu_mem_clock = gpus->active_gpu()->metrics.MemClock;
+      data.gpu_vram_used = gpus->active_gpu()->metrics.sys_vram_used;
+      data.gpu_power = gpus->active_gpu()->metrics.powerUsage;
    }
-
 #ifdef __linux__
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_battery])
-      Battery_Stats.update();
-   if (!real_params->device_battery.empty()) {
-      device_update(params);
-      if (device_found) {
-            device_info();
-      }
+   auto meminfo = get_meminfo();
+   data.ram_used = meminfo->used();
+   data.swap_used = meminfo->swap_used();
+   data.process_rss = proc_mem_resident / float((2 << 29)); // GiB, consistent w/ other mem stats
+   auto pressure = g_pressure.load();
+   snapshot.psi_valid = pressure && pressure->valid();
+   for (size_t i = 0; i < PRESSURE_COUNT; i++) {
+      auto resource = pressure_resource(i);
+      auto& row = snapshot.psi[i];
+      row.some = pressure ? (*pressure)[resource].some.load() : 0.f;
+      row.full = pressure ? (*pressure)[resource].full.load() : 0.f;
+      row.stalling = pressure && pressure->stalling(resource);
    }
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_ram] || real_params->enabled[OVERLAY_PARAM_ENABLED_swap] || logger->is_active())
-      update_meminfo();
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_ram_temp])
-      update_mem_temp();
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_procmem])
-      update_procmem();
-   if (real_params->enabled[OVERLAY_PARAM_ENABLED_io_read] || real_params->enabled[OVERLAY_PARAM_ENABLED_io_write])
-      getIoStats(g_io_stats);
+   data.psi_cpu = snapshot.psi[PRESSURE_CPU].some;
+   data.psi_memory = snapshot.psi[PRESSURE_MEMORY].some;
+   data.psi_io = snapshot.psi[PRESSURE_IO].some;
+
+   snapshot.thread_count = g_thread_stats.top(snapshot.threads);
+
+   snapshot.net.clear();
+   if (auto net = HUDElements.net.load())
+      if (auto throughput = net->throughput())
+         snapshot.net.assign(throughput->begin(), throughput->end());
+
+   snapshot.io_read = g_io_stats.per_second.read;
+   snapshot.io_write = g_io_stats.per_second.write;
+   snapshot.proc_mem_resident = proc_mem_resident;
+   snapshot.proc_mem_shared = proc_mem_shared;
+   snapshot.proc_mem_virt = proc_mem_virt;
 #endif
-   if (gpus && gpus->active_gpu()) {
-      currentLogData.gpu_load = gpus->active_gpu()->metrics.load;
-      currentLogData.gpu_temp = gpus->active_gpu()->metrics.temp;
-      currentLogData.gpu_core_clock = gpus->active_gpu()->metrics.CoreClock;
-      currentLogData.gpu_mem_clock = gpus->active_gpu()->metrics.MemClock;
-      currentLogData.gpu_vram_used = gpus->active_gpu()->metrics.sys_vram_used;
-      currentLogData.gpu_power = gpus->active_gpu()->metrics.powerUsage;
+
+   data.cpu_load = cpuStats.GetCPUDataTotal().percent;
+   data.cpu_temp = cpuStats.GetCPUDataTotal().temp;
+   data.cpu_power = cpuStats.GetCPUDataTotal().power;
+   data.cpu_mhz = cpuStats.GetCPUDataTotal().cpu_mhz;
+   auto& cpus = cpuStats.GetCPUData();
+   snapshot.core_load.assign(cpuStats.GetCoreLoad().begin(), cpuStats.GetCoreLoad().end());
+   snapshot.core_mhz.resize(cpus.size());
+   snapshot.core_id.resize(cpus.size());
+   snapshot.core_label.resize(cpus.size());
+   for (size_t i = 0; i < cpus.size(); i++) {
+      snapshot.core_mhz[i] = cpus[i].mhz;
+      snapshot.core_id[i] = cpus[i].cpu_id;
+      snapshot.core_label[i] = cpus[i].label;
    }
-#ifdef __linux__
-   currentLogData.ram_used = memused;
-   currentLogData.swap_used = swapused;
-   currentLogData.process_rss = proc_mem_resident / float((2 << 29)); // GiB, consistent w/ other mem stats
-#endif
 
-   currentLogData.cpu_load = cpuStats.GetCPUDataTotal().percent;
-   currentLogData.cpu_temp = cpuStats.GetCPUDataTotal().temp;
-   currentLogData.cpu_power = cpuStats.GetCPUDataTotal().power;
-   currentLogData.cpu_mhz = cpuStats.GetCPUDataTotal().cpu_mhz;
+   if (log_schema)
+      log_schema->sample(snapshot.log_extra);
+   else
+      snapshot.log_extra.clear();
 
-   // Save data for graphs
-   if (graph_data.size() >= kMaxGraphEntries)
-      graph_data.pop_front();
-   graph_data.push_back(currentLogData);
+   g_hw_snapshot.publish();
    if (logger) logger->notify_data_valid();
    HUDElements.update_exec();
 }
 
+/*
+ * Polls every hw info source at its own rate. Each source declares a period
+ * and a rough cost and is only polled while an enabled HUD element or the
+ * running log needs it. The thread only wakes up for ticks where a needed
+ * source is due; once the app stops presenting for a while it goes idle
+ * until the next present.
+ */
 struct hw_info_updater
 {
+   using clock = std::chrono::steady_clock;
+
    bool quit = false;
    std::thread thread {};
    const struct overlay_params* params = nullptr;
    uint32_t vendorID;
-   bool update_hw_info_thread = false;
+   clock::time_point last_kick {};
 
    std::condition_variable cv_hwupdate;
-   std::mutex m_cv_hwupdate, m_hw_updating;
+   std::mutex m_cv_hwupdate;
+
+   timer_wheel wheel;
+   clock::duration tick {};
+   uint64_t base_period = 0;
+   std::shared_ptr<overlay_params> real_params;
+   std::shared_ptr<const LogSchema> log_schema;
 
    hw_info_updater()
    {
@@ -186,7 +212,10 @@ struct hw_info_updater
 
    ~hw_info_updater()
    {
-      quit = true;
+      {
+         std::lock_guard<std::mutex> lk(m_cv_hwupdate);
+         quit = true;
+      }
       cv_hwupdate.notify_all();
       if (thread.joinable())
          thread.join();
@@ -194,28 +223,161 @@ struct hw_info_updater
 
    void update(const struct overlay_params* params_, uint32_t vendorID_)
    {
-      std::unique_lock<std::mutex> lk_hw_updating(m_hw_updating, std::try_to_lock);
-      if (lk_hw_updating.owns_lock())
+      // Don't stall the present thread, a missed kick is picked up by the next one
+      std::unique_lock<std::mutex> lk(m_cv_hwupdate, std::try_to_lock);
+      if (lk.owns_lock())
       {
          params = params_;
          vendorID = vendorID_;
-         update_hw_info_thread = true;
+         last_kick = clock::now();
+         lk.unlock();
          cv_hwupdate.notify_all();
       }
    }
 
+   bool enabled(overlay_param_enabled e) const { return real_params->enabled[e]; }
+   bool wants(log_source source) const { return log_wants(log_schema, source); }
+
+   uint32_t ticks(std::chrono::nanoseconds period) const
+   {
+      return std::max<uint32_t>(1, (period + tick / 2) / tick);
+   }
+
+   void add_source(const char* name, std::chrono::nanoseconds period, uint32_t cost,
+                   std::function<bool()> needed, std::function<void()> poll)
+   {
+      auto stage = g_overhead.stage(name);
+      wheel.add({name, ticks(period), cost, std::move(needed), [stage, poll = std::move(poll)]{
+         ScopedOverhead timer(stage);
+         poll();
+      }});
+   }
+
+   void build_sources(uint64_t sampling_period)
+   {
+      using namespace std::chrono_literals;
+      const std::chrono::nanoseconds base {sampling_period};
+      const auto fast = base / 2;
+
+      base_period = sampling_period;
+      tick = std::clamp<clock::duration>(fast, 10ms, 50ms);
+      wheel.clear();
+
+      add_source("fan", 1s, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_fan); },
+         []{ update_fan(); });
+      add_source("cpu", base, 2,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_cpu_stats) || wants(LOG_SOURCE_CPU); },
+         []{ cpuStats.UpdateCPUData(); });
+      add_source("gpu", fast, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_gpu_stats) || wants(LOG_SOURCE_GPU); },
+         []{ if (gpus) gpus->get_metrics(); });
+#ifdef __linux__
+      add_source("core_mhz", base, 3,
+         [this]{ return (enabled(OVERLAY_PARAM_ENABLED_cpu_stats) || wants(LOG_SOURCE_CPU)) &&
+                        (enabled(OVERLAY_PARAM_ENABLED_core_load) || enabled(OVERLAY_PARAM_ENABLED_cpu_mhz) || wants(LOG_SOURCE_CPU_MHZ)); },
+         []{ cpuStats.UpdateCoreMhz(); });
+      add_source("cpu_temp", base, 1,
+         [this]{ return (enabled(OVERLAY_PARAM_ENABLED_cpu_stats) || wants(LOG_SOURCE_CPU)) &&
+                        (enabled(OVERLAY_PARAM_ENABLED_cpu_temp) || enabled(OVERLAY_PARAM_ENABLED_graphs) || wants(LOG_SOURCE_CPU_TEMP)); },
+         []{ cpuStats.UpdateCpuTemp(); });
+      add_source("cpu_power", fast, 1,
+         [this]{ return (enabled(OVERLAY_PARAM_ENABLED_cpu_stats) || wants(LOG_SOURCE_CPU)) &&
+                        (enabled(OVERLAY_PARAM_ENABLED_cpu_power) || wants(LOG_SOURCE_CPU_POWER)); },
+         []{ cpuStats.UpdateCpuPower(); });
+      add_source("battery", 5s, 2,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_battery); },
+         []{ Battery_Stats.update(); });
+      add_source("device_battery", 5s, 3,
+         [this]{ return !real_params->device_battery.empty(); },
+         [this]{
+            device_update(*params);
+            if (device_found)
+               device_info();
+         });
+      add_source("meminfo", 1s, 2,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_ram) || enabled(OVERLAY_PARAM_ENABLED_swap) ||
+                        wants(LOG_SOURCE_MEMINFO) || wants(LOG_SOURCE_MEMINFO_EXT); },
+         [this]{ update_meminfo(wants(LOG_SOURCE_MEMINFO_EXT) ? MEMINFO_ALL_KEYS : MEMINFO_BASIC_KEYS); });
+      add_source("mem_temp", 2s, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_ram_temp); },
+         []{ update_mem_temp(); });
+      add_source("procmem", base, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_procmem) || wants(LOG_SOURCE_PROCMEM); },
+         []{ update_procmem(); });
+      add_source("io", base, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_io_read) || enabled(OVERLAY_PARAM_ENABLED_io_write) || wants(LOG_SOURCE_IO); },
+         []{ getIoStats(g_io_stats); });
+      // Only poll while the network element is shown or the log wants it
+      add_source("net", base, 1,
+         [this]{ return (!real_params->network.empty() && !real_params->no_display) || wants(LOG_SOURCE_NET); },
+         []{
+            auto net = HUDElements.net.load();
+            if (!net) {
+               net = std::make_shared<Net>();
+               HUDElements.net.store(net);
+            }
+            net->update();
+         });
+      add_source("pressure", base, 1,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_pressure) || enabled(OVERLAY_PARAM_ENABLED_graphs) || wants(LOG_SOURCE_PRESSURE); },
+         [this]{
+            bool cgroup = enabled(OVERLAY_PARAM_ENABLED_pressure_cgroup);
+            auto pressure = g_pressure.load();
+            if (!pressure || pressure->cgroup() != cgroup) {
+               pressure = std::make_shared<Pressure>(cgroup);
+               g_pressure.store(pressure);
+            }
+            pressure->update();
+         });
+      add_source("threads", base, 2,
+         [this]{ return enabled(OVERLAY_PARAM_ENABLED_thread_load) || wants(LOG_SOURCE_THREADS); },
+         [this]{
+            g_thread_stats.update(HUDElements.g_gamescopePid,
+               enabled(OVERLAY_PARAM_ENABLED_thread_load) ? real_params->thread_load_count : 0);
+         });
+#endif
+      // Not timed itself, it summarizes the other stages
+      wheel.add({"overhead", ticks(1s), 0, {}, []{ g_overhead.roll(); }});
+      // Added last so it runs after any source that shares its tick
+      add_source("publish", base, 0, {},
+         [this]{ publish_hw_info(log_schema); });
+   }
+
    void run(){
+      auto next_tick = clock::now();
       while (!quit){
-         std::unique_lock<std::mutex> lk_cv_hwupdate(m_cv_hwupdate);
-         cv_hwupdate.wait(lk_cv_hwupdate, [&]{ return update_hw_info_thread || quit; });
-         if (quit) break;
-
-         if (params)
          {
-            std::unique_lock<std::mutex> lk_hw_updating(m_hw_updating);
-            update_hw_info(*params, vendorID);
+            std::unique_lock<std::mutex> lk(m_cv_hwupdate);
+            // Stop polling when the app stops presenting
+            auto idle_after = std::max<clock::duration>(std::chrono::seconds(1),
+               std::chrono::nanoseconds(base_period * 4));
+            cv_hwupdate.wait(lk, [&]{ return quit || (params && clock::now() - last_kick < idle_after); });
+            if (quit) break;
+
+            cv_hwupdate.wait_until(lk, next_tick, [&]{ return quit; });
+            if (quit) break;
+         }
+
+         real_params = get_params();
+         if (wheel.empty() || real_params->fps_sampling_period != base_period) {
+            build_sources(real_params->fps_sampling_period);
+            next_tick = clock::now();
          }
-         update_hw_info_thread = false;
+
+         log_schema.reset();
+         if (logger && logger->is_active())
+            log_schema = logger->schema();
+
+         wheel.tick();
+
+         // Sleep through the ticks where no needed source is due
+         auto idle = wheel.idle_ticks();
+         wheel.skip(idle);
+         next_tick += tick * (idle + 1);
+         // Don't try to catch up after a stall, just keep the rate
+         if (next_tick < clock::now())
+            next_tick = clock::now() + tick;
       }
    }
 };
@@ -265,12 +427,19 @@ void update_hud_info_with_frametime(struct swapchain_stats& sw_stats, const stru
       hw_update_thread->update(&params, vendorID);
 
       if (fpsmetrics) fpsmetrics->update_thread();
-#ifdef __linux__
-      if (HUDElements.net) HUDElements.net->update();
-#endif
 
       sw_stats.fps = 1000000000.0 * sw_stats.n_frames_since_update / elapsed;
 
+      if (real_params->enabled[OVERLAY_PARAM_ENABLED_gpu_efficiency]) {
+         auto gpu = gpus ? gpus->active_gpu() : nullptr;
+         double joules = gpu && gpu->amdgpu ? gpu->amdgpu->energy().joules : 0.;
+         if (joules > sw_stats.gpu_energy_joules && sw_stats.gpu_energy_joules > 0.)
+            sw_stats.gpu_joules_per_frame = (joules - sw_stats.gpu_energy_joules) / sw_stats.n_frames_since_update;
+         else if (joules <= 0.)
+            sw_stats.gpu_joules_per_frame = 0.f;
+         sw_stats.gpu_energy_joules = joules;
+      }
+
       if (real_params->enabled[OVERLAY_PARAM_ENABLED_time]) {
          std::time_t t = std::time(nullptr);
          std::stringstream time;
@@ -666,8 +835,12 @@ void render_imgui(swapchain_stats& data, struct overlay_params& params, ImVec2&
       std::unique_lock<std::mutex> lock(config_mtx);
       config_cv.wait(lock, []{ return config_ready; });
    }
+   // Waiting for the config isn't render cost
+   static const size_t render_stage = g_overhead.stage("render_imgui");
+   ScopedOverhead timer(render_stage);
    // data.engine = EngineTypes::GAMESCOPE;
    HUDElements.sw_stats = &data;
+   HUDElements.hw = &g_hw_snapshot.hud();
    auto real_params = get_params();
    if (real_params)
       HUDElements.params = real_params;
@@ -13,13 +13,12 @@
 
 #include "dbus_info.h"
 #include "logging.h"
+#include "hw_snapshot.h"
 
 struct frame_stat {
    uint64_t stats[OVERLAY_PLOTS_MAX];
 };
 
-static const int kMaxGraphEntries = 50;
-
 enum EngineTypes
 {
    UNKNOWN,
@@ -53,6 +52,10 @@ struct swapchain_stats {
    size_t font_params_hash = 0;
    std::string time;
    double fps;
+   // GPU energy counter at the last fps update and the joules each frame
+   // since then took, 0 when the GPU doesn't report energy
+   double gpu_energy_joules;
+   float gpu_joules_per_frame;
    uint64_t last_present_time;
    unsigned n_frames_since_update;
    uint64_t last_fps_update;
@@ -143,7 +146,6 @@ extern uint32_t deviceID;
 extern struct benchmark_stats benchmark;
 extern ImVec2 real_font_size;
 extern std::string wineVersion;
-extern std::deque<logData> graph_data;
 extern double min_frametime, max_frametime;
 extern bool steam_focused;
 extern int fan_speed;
@@ -157,7 +159,6 @@ void position_layer(struct swapchain_stats& data, const struct overlay_params& p
 void render_imgui(swapchain_stats& data, struct overlay_params& params, ImVec2& window_size, bool is_vulkan);
 void update_hud_info(struct swapchain_stats& sw_stats, const struct overlay_params& params, uint32_t vendorID);
 void update_hud_info_with_frametime(struct swapchain_stats& sw_stats, const struct overlay_params& params, uint32_t vendorID, uint64_t frametime_ns);
-void update_hw_info(const struct overlay_params& params, uint32_t vendorID);
 void init_cpu_stats(overlay_params& params);
 void check_keybinds(overlay_params& params);
 void init_system_info(void);
@@ -466,6 +466,50 @@ parse_gl_size_query(const char *str)
    return GL_SIZE_DRAWABLE;
 }
 
+static enum log_format
+parse_log_format(const char *str)
+{
+   std::string value(str);
+   trim(value);
+   std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+   if (value == "binary")
+      return LOG_FORMAT_BINARY;
+   if (value != "csv")
+      SPDLOG_ERROR("Unknown log_format '{}', using csv", value);
+   return LOG_FORMAT_CSV;
+}
+
+static struct log_compression
+parse_log_compression(const char *str)
+{
+   // codec[+level], e.g. zstd or zstd+19
+   struct log_compression compression {LOG_COMPRESSION_NONE, 0};
+   auto tokens = str_tokenize(str, ":+");
+   if (tokens.empty())
+      return compression;
+
+   auto codec = tokens[0];
+   trim(codec);
+   std::transform(codec.begin(), codec.end(), codec.begin(), ::tolower);
+   if (codec == "zstd") {
+      compression = {LOG_COMPRESSION_ZSTD, 3};
+   } else if (codec == "lz4") {
+      compression = {LOG_COMPRESSION_LZ4, 0};
+   } else if (codec != "none" && codec != "0") {
+      SPDLOG_ERROR("Unknown log_compression '{}', logs won't be compressed", codec);
+      return compression;
+   }
+
+   if (tokens.size() > 1) {
+      try {
+         compression.level = std::stoi(tokens[1]);
+      } catch (const std::exception& e) {
+         SPDLOG_ERROR("Invalid log_compression level '{}'", tokens[1]);
+      }
+   }
+   return compression;
+}
+
 static std::vector<std::string>
 parse_fps_metrics(const char *str){
    std::vector<std::string> metrics;
@@ -596,6 +640,8 @@ parse_ftrace(const char *str) {
 #define parse_cpu_text(s) parse_str(s)
 #define parse_fps_text(s) parse_str(s)
 #define parse_log_interval(s) parse_unsigned(s)
+#define parse_thread_load_count(s) parse_unsigned(s)
+#define parse_gpu_sample_period(s) parse_unsigned(s)
 #define parse_font_size(s) parse_float(s)
 #define parse_font_size_secondary(s) parse_float(s)
 #define parse_font_size_text(s) parse_float(s)
@@ -644,6 +690,7 @@ parse_ftrace(const char *str) {
 #define parse_text_outline_thickness(s) parse_float(s)
 #define parse_device_battery(s) parse_str_tokenize(s)
 #define parse_network(s) parse_str_tokenize(s)
+#define parse_log_columns(s) parse_str_tokenize(s)
 #define parse_gpu_text(s) parse_str_tokenize(s)
 
 static bool
@@ -660,6 +707,8 @@ parse_help(const char *str)
    fprintf(stderr, "\tfps_sampling_period=number-of-milliseconds\n");
    fprintf(stderr, "\tno_display=0|1\n");
    fprintf(stderr, "\toutput_folder=/path/to/folder\n");
+   fprintf(stderr, "\tlog_format=csv|binary\n");
+   fprintf(stderr, "\tlog_compression=none|zstd[+level]|lz4[+level]\n");
    fprintf(stderr, "\twidth=width-in-pixels\n");
    fprintf(stderr, "\theight=height-in-pixels\n");
 
@@ -769,6 +818,9 @@ set_parameters_from_options(struct overlay_params *params)
       params->enabled[OVERLAY_PARAM_ENABLED_read_cfg] = read_cfg;
       params->enabled[OVERLAY_PARAM_ENABLED_time_no_label] = false;
       params->enabled[OVERLAY_PARAM_ENABLED_core_type] = false;
+      params->enabled[OVERLAY_PARAM_ENABLED_mangohud_overhead] = false;
+      params->enabled[OVERLAY_PARAM_ENABLED_pressure_cgroup] = false;
+      params->enabled[OVERLAY_PARAM_ENABLED_thread_load] = false;
       params->options.erase("full");
    }
    for (auto& it : params->options) {
@@ -916,6 +968,10 @@ static void set_param_defaults(struct overlay_params *params){
    params->cpu_load_color = { 0x39f900, 0xfdfd09, 0xb22222 };
    params->font_scale_media_player = 0.55f;
    params->log_interval = 0;
+   params->log_format = LOG_FORMAT_CSV;
+   params->thread_load_count = 5;
+   params->gpu_sample_period = 25;
+   params->log_compression = {LOG_COMPRESSION_NONE, 0};
    params->media_player_format = { "{title}", "{artist}", "{album}" };
    params->permit_upload = 0;
    params->benchmark_percentiles = { "97", "AVG"};
@@ -1185,8 +1241,8 @@ parse_overlay_config(struct overlay_params *params,
    mangoapp_cv.notify_one();
    g_fsrSharpness = params->fsr_steam_sharpness;
 #endif
-   if (HUDElements.net)
-      HUDElements.net->should_reset = true;
+   if (auto net = HUDElements.net.load())
+      net->should_reset = true;
 
    // If both options are specified, GPUS::selected_gpus() is going
    // to return only GPUs listed in gpu_list
@@ -128,6 +128,10 @@ struct Tracepoint;
    OVERLAY_PARAM_BOOL(frame_timing_detailed)         \
    OVERLAY_PARAM_BOOL(winesync)                      \
    OVERLAY_PARAM_BOOL(present_mode)                  \
+   OVERLAY_PARAM_BOOL(mangohud_overhead)             \
+   OVERLAY_PARAM_BOOL(pressure)                      \
+   OVERLAY_PARAM_BOOL(pressure_cgroup)               \
+   OVERLAY_PARAM_BOOL(thread_load)                   \
    OVERLAY_PARAM_BOOL(time_no_label)                 \
    OVERLAY_PARAM_BOOL(display_server)                \
    OVERLAY_PARAM_BOOL(cpu_efficiency)                \
@@ -197,6 +201,11 @@ struct Tracepoint;
    OVERLAY_PARAM_CUSTOM(cpu_text)                    \
    OVERLAY_PARAM_CUSTOM(gpu_text)                    \
    OVERLAY_PARAM_CUSTOM(log_interval)                \
+   OVERLAY_PARAM_CUSTOM(log_format)                  \
+   OVERLAY_PARAM_CUSTOM(thread_load_count)           \
+   OVERLAY_PARAM_CUSTOM(gpu_sample_period)           \
+   OVERLAY_PARAM_CUSTOM(log_columns)                 \
+   OVERLAY_PARAM_CUSTOM(log_compression)             \
    OVERLAY_PARAM_CUSTOM(permit_upload)               \
    OVERLAY_PARAM_CUSTOM(benchmark_percentiles)       \
    OVERLAY_PARAM_CUSTOM(help)                        \
@@ -267,6 +276,22 @@ enum fps_limit_method {
    FPS_LIMIT_METHOD_LATE
 };
 
+enum log_format {
+   LOG_FORMAT_CSV,
+   LOG_FORMAT_BINARY,
+};
+
+enum log_compression_codec {
+   LOG_COMPRESSION_NONE,
+   LOG_COMPRESSION_ZSTD,
+   LOG_COMPRESSION_LZ4,
+};
+
+struct log_compression {
+   enum log_compression_codec codec;
+   int level;
+};
+
 enum overlay_param_enabled {
 #define OVERLAY_PARAM_BOOL(name) OVERLAY_PARAM_ENABLED_##name,
 #define OVERLAY_PARAM_CUSTOM(name)
@@ -309,6 +334,11 @@ struct overlay_params {
    enum gl_size_query gl_size_query {GL_SIZE_DRAWABLE};
    bool gl_dont_flip {false};
    int64_t log_duration, log_interval;
+   enum log_format log_format;
+   unsigned thread_load_count;
+   unsigned gpu_sample_period; /* ms */
+   std::vector<std::string> log_columns;
+   struct log_compression log_compression;
    unsigned cpu_color, gpu_color, vram_color, ram_color,
             engine_color, io_color, frametime_color, background_color,
             text_color, wine_color, battery_color, network_color,
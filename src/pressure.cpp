@@ -0,0 +1,162 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "pressure.h"
+
+std::atomic<std::shared_ptr<Pressure>> g_pressure;
+
+static const char* pressure_names[PRESSURE_COUNT] = {"cpu", "memory", "io"};
+
+// Directory of the cgroup v2 this process belongs to, empty without one
+static std::string own_cgroup_dir() {
+    auto cgroups = read_line("/proc/self/cgroup");
+    // cgroup v2 only has the "0::/path" line
+    if (cgroups.rfind("0::", 0) != 0)
+        return {};
+    return "/sys/fs/cgroup" + cgroups.substr(3);
+}
+
+static int open_trigger(const std::string& path) {
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        SPDLOG_DEBUG("Failed to open {} for a PSI trigger: {}", path, strerror(errno));
+        return -1;
+    }
+
+    auto trigger = fmt::format("some {} {}", Pressure::trigger_threshold_us, Pressure::trigger_window_us);
+    // the kernel expects the terminating null byte
+    if (write(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+        SPDLOG_DEBUG("Failed to set PSI trigger on {}: {}", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+Pressure::Pressure(bool cgroup) : m_cgroup(cgroup) {
+    std::string dir = "/proc/pressure/";
+    std::string suffix;
+    if (cgroup) {
+        auto cgroup_dir = own_cgroup_dir();
+        if (cgroup_dir.empty() || access((cgroup_dir + "/cpu.pressure").c_str(), R_OK)) {
+            SPDLOG_WARN("No cgroup pressure files, using /proc/pressure");
+        } else {
+            dir = cgroup_dir + "/";
+            suffix = ".pressure";
+        }
+    }
+
+    for (size_t i = 0; i < PRESSURE_COUNT; i++) {
+        auto path = dir + pressure_names[i] + suffix;
+        if (!m_sources[i].file.open(path))
+            continue;
+        m_valid = true;
+        m_sources[i].trigger_fd = open_trigger(path);
+    }
+
+    if (!m_valid) {
+        SPDLOG_ERROR("Pressure stall information is not available, kernel needs CONFIG_PSI");
+        return;
+    }
+
+    bool triggers = false;
+    for (auto& src : m_sources)
+        triggers |= src.trigger_fd >= 0;
+    if (!triggers)
+        return;
+
+    m_wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (m_wake_fd < 0) {
+        SPDLOG_DEBUG("Failed to create eventfd for PSI triggers: {}", strerror(errno));
+        return;
+    }
+    m_trigger_thread = std::thread(&Pressure::wait_triggers, this);
+    pthread_setname_np(m_trigger_thread.native_handle(), "mangohud-psi");
+}
+
+Pressure::~Pressure() {
+    if (m_trigger_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(m_wake_fd, &one, sizeof(one)) < 0)
+            SPDLOG_DEBUG("Failed to wake the PSI trigger thread: {}", strerror(errno));
+        m_trigger_thread.join();
+    }
+    if (m_wake_fd >= 0)
+        close(m_wake_fd);
+    for (auto& src : m_sources)
+        if (src.trigger_fd >= 0)
+            close(src.trigger_fd);
+}
+
+// Sleeps until a trigger fires or the destructor wakes it
+void Pressure::wait_triggers() {
+    std::array<pollfd, PRESSURE_COUNT + 1> fds;
+    for (size_t i = 0; i < PRESSURE_COUNT; i++)
+        fds[i] = {m_sources[i].trigger_fd, POLLPRI, 0};
+    fds[PRESSURE_COUNT] = {m_wake_fd, POLLIN, 0};
+
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            SPDLOG_DEBUG("poll on PSI triggers failed: {}", strerror(errno));
+            return;
+        }
+        if (fds[PRESSURE_COUNT].revents)
+            return;
+
+        int64_t now = os_time_get_nano();
+        for (size_t i = 0; i < PRESSURE_COUNT; i++) {
+            if (fds[i].revents & POLLERR) {
+                // the cgroup went away, the fd is closed with the rest
+                fds[i].fd = -1;
+            } else if (fds[i].revents & POLLPRI) {
+                m_stats[i].events++;
+                m_stats[i].last_event_ns = now;
+            }
+        }
+    }
+}
+
+bool Pressure::stalling(pressure_resource r) const {
+    auto last = m_stats[r].last_event_ns.load();
+    return last && os_time_get_nano() - last < int64_t(trigger_window_us * 1000);
+}
+
+void Pressure::update() {
+    auto now = Clock::now();
+    float elapsed_us = std::chrono::duration<float, std::micro>(now - m_last_update).count();
+    bool first = m_last_update.time_since_epoch().count() == 0;
+    m_last_update = now;
+
+    for (size_t i = 0; i < PRESSURE_COUNT; i++) {
+        auto& src = m_sources[i];
+        // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0", then the same for "full"
+        auto contents = src.file.read();
+        while (!contents.empty()) {
+            auto line = next_line(contents);
+            auto pos = line.find("total=");
+            if (pos == std::string_view::npos)
+                continue;
+
+            auto val = line.substr(pos + 6);
+            uint64_t total;
+            if (!scan_u64(val, total))
+                continue;
+
+            bool some = line.rfind("some", 0) == 0;
+            auto& previous = some ? src.some_total : src.full_total;
+            if (!first) {
+                float percent = std::min(100.f, (total - previous) / elapsed_us * 100.f);
+                (some ? m_stats[i].some : m_stats[i].full) = percent;
+            }
+            previous = total;
+        }
+    }
+}
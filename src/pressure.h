@@ -0,0 +1,82 @@
+#pragma once
+#ifndef MANGOHUD_PRESSURE_H
+#define MANGOHUD_PRESSURE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "file_utils.h"
+#include "timing.hpp"
+
+enum pressure_resource {
+    PRESSURE_CPU,
+    PRESSURE_MEMORY,
+    PRESSURE_IO,
+    PRESSURE_COUNT
+};
+
+struct pressure_stats {
+    // percent of the last update interval in which some / all non-idle
+    // tasks were stalled on the resource
+    std::atomic<float> some {0.f};
+    std::atomic<float> full {0.f};
+    // number of stall spikes reported by the PSI trigger
+    std::atomic<uint32_t> events {0};
+    std::atomic<int64_t> last_event_ns {0};
+};
+
+// Pressure stall information from /proc/pressure, or from the *.pressure
+// files of the game's cgroup with pressure_cgroup. Stall percentages come
+// from the deltas of the total= counters between updates, so they aren't
+// limited to the 10s resolution of avg10.
+//
+// Spikes are caught by a PSI trigger on each file. A thread blocks in
+// poll() on the trigger fds, so events counts every event the kernel
+// reported and last_event_ns is the time it woke up for it.
+class Pressure {
+public:
+    // stall time within the window that counts as a spike
+    static constexpr uint64_t trigger_threshold_us = 100000;
+    // unprivileged triggers need a multiple of 2s
+    static constexpr uint64_t trigger_window_us = 2000000;
+
+    explicit Pressure(bool cgroup);
+    ~Pressure();
+    Pressure(const Pressure&) = delete;
+    Pressure& operator=(const Pressure&) = delete;
+
+    void update();
+    bool valid() const { return m_valid; }
+    bool cgroup() const { return m_cgroup; }
+    const pressure_stats& operator[](pressure_resource r) const { return m_stats[r]; }
+    // an event fired within the last trigger window
+    bool stalling(pressure_resource r) const;
+
+private:
+    struct source {
+        persistent_file file;
+        int trigger_fd = -1;
+        uint64_t some_total = 0;
+        uint64_t full_total = 0;
+    };
+
+    void wait_triggers();
+
+    std::array<source, PRESSURE_COUNT> m_sources;
+    std::array<pressure_stats, PRESSURE_COUNT> m_stats;
+    // written to stop the trigger thread
+    int m_wake_fd = -1;
+    std::thread m_trigger_thread;
+    Clock::time_point m_last_update {};
+    bool m_cgroup;
+    bool m_valid = false;
+};
+
+// Created and replaced by the hw info thread, readers load their own reference
+extern std::atomic<std::shared_ptr<Pressure>> g_pressure;
+
+#endif //MANGOHUD_PRESSURE_H
@@ -0,0 +1,187 @@
+#include <climits>
+#include <cstring>
+#include "proc_stat.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PROC_STAT_SWAR 1
+#endif
+
+#ifdef PROC_STAT_SWAR
+// Number of leading decimal digits in the 8 bytes of `chunk` (first byte
+// in the low bits). Assumes ASCII input, which /proc/stat is.
+static inline unsigned digit_count(uint64_t chunk)
+{
+   const uint64_t high_nibble = (chunk & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL;
+   const uint64_t low_nibble = ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL;
+   const uint64_t non_digit = high_nibble | low_nibble;
+   // 0x80 in every byte of non_digit that is non-zero
+   const uint64_t flags = (((non_digit & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | non_digit) & 0x8080808080808080ULL;
+   return flags ? __builtin_ctzll(flags) / 8 : 8;
+}
+
+// Value of the first `count` (1..8) digits of `chunk`
+static inline uint64_t digits_value(uint64_t chunk, unsigned count)
+{
+   // move the digits to the top, the zero bytes shifted in read as leading zeros
+   chunk <<= 8 * (8 - count);
+   chunk = (chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+   chunk = (chunk & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+   return (chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+
+static const uint64_t pow10[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+#endif
+
+const char* parse_proc_stat_u64(const char* p, const char* end, uint64_t& value)
+{
+   uint64_t v = 0;
+   const char* start = p;
+
+#ifdef PROC_STAT_SWAR
+   // 8 digits per step while a whole word can be loaded
+   while (end - p >= 8) {
+      uint64_t chunk;
+      memcpy(&chunk, p, sizeof(chunk));
+      unsigned count = digit_count(chunk);
+      if (count == 0)
+         break;
+      v = v * pow10[count] + digits_value(chunk, count);
+      p += count;
+      if (count < 8) {
+         value = v;
+         return p;
+      }
+   }
+#endif
+
+   while (p < end && *p >= '0' && *p <= '9')
+      v = v * 10 + (*p++ - '0');
+
+   if (p != start)
+      value = v;
+   return p;
+}
+
+static inline const char* skip_blanks(const char* p, const char* end)
+{
+   while (p < end && *p == ' ')
+      p++;
+   return p;
+}
+
+// Parses the counters following "cpu" or "cpuN", p points past the label
+static const char* parse_fields(const char* p, const char* end, uint64_t* values)
+{
+   for (size_t i = 0; i < PROC_STAT_FIELD_COUNT; i++) {
+      p = skip_blanks(p, end);
+      uint64_t v = 0;
+      p = parse_proc_stat_u64(p, end, v);
+      values[i] = v;
+   }
+   return p;
+}
+
+static inline const char* next_line(const char* p, const char* end)
+{
+   auto nl = static_cast<const char*>(memchr(p, '\n', end - p));
+   return nl ? nl + 1 : end;
+}
+
+bool parse_proc_stat(std::string_view contents, proc_stat_counters& out)
+{
+   const char* p = contents.data();
+   const char* end = p + contents.size();
+
+   if (end - p < 4 || memcmp(p, "cpu ", 4) != 0)
+      return false;
+
+   p = parse_fields(p + 4, end, out.total.data());
+   p = next_line(p, end);
+
+   size_t n = 0;
+   uint64_t row[PROC_STAT_FIELD_COUNT];
+   while (end - p > 3 && memcmp(p, "cpu", 3) == 0) {
+      uint64_t id = 0;
+      const char* q = parse_proc_stat_u64(p + 3, end, id);
+      if (q == p + 3)
+         break;
+
+      q = parse_fields(q, end, row);
+      if (n == out.size())
+         out.resize(n + 1);
+      out.cpu_id[n] = id;
+      for (size_t f = 0; f < PROC_STAT_FIELD_COUNT; f++)
+         out.cpu[f][n] = row[f];
+      n++;
+      p = next_line(q, end);
+   }
+
+   if (n != out.size())
+      out.resize(n);
+   return true;
+}
+
+// Guest time is already accounted in user and nice, and iowait counts as
+// idle. Counters can step back (iowait does), such deltas count as 0.
+static inline int32_t jiffies_delta(uint64_t now, uint64_t prev)
+{
+   uint64_t delta = now - prev;
+   return delta > uint64_t(INT32_MAX) ? 0 : int32_t(delta);
+}
+
+static inline float load_percent(int32_t busy_delta, int32_t period, float previous)
+{
+   float load = 100.f * float(busy_delta) / float(period > 1 ? period : 1);
+   load = load < 100.f ? load : 100.f;
+   return period > 0 ? load : previous;
+}
+
+void proc_stat_load::update(const proc_stat_counters& stat)
+{
+   const auto& t = stat.total;
+   uint64_t b = t[PROC_STAT_USER] + t[PROC_STAT_NICE] + t[PROC_STAT_SYSTEM] +
+                t[PROC_STAT_IRQ] + t[PROC_STAT_SOFTIRQ] + t[PROC_STAT_STEAL];
+   uint64_t all = b + t[PROC_STAT_IDLE] + t[PROC_STAT_IOWAIT];
+   all_period = jiffies_delta(all, all_total);
+   all_load = load_percent(jiffies_delta(b, all_busy), all_period, all_load);
+   all_busy = b;
+   all_total = all;
+
+   const size_t n = stat.size();
+   if (load.size() != n) {
+      busy.resize(n);
+      total.resize(n);
+      busy_delta.resize(n);
+      period.resize(n);
+      load.resize(n);
+   }
+
+   const uint64_t* __restrict user = stat.cpu[PROC_STAT_USER].data();
+   const uint64_t* __restrict nice = stat.cpu[PROC_STAT_NICE].data();
+   const uint64_t* __restrict system = stat.cpu[PROC_STAT_SYSTEM].data();
+   const uint64_t* __restrict idle = stat.cpu[PROC_STAT_IDLE].data();
+   const uint64_t* __restrict iowait = stat.cpu[PROC_STAT_IOWAIT].data();
+   const uint64_t* __restrict irq = stat.cpu[PROC_STAT_IRQ].data();
+   const uint64_t* __restrict softirq = stat.cpu[PROC_STAT_SOFTIRQ].data();
+   const uint64_t* __restrict steal = stat.cpu[PROC_STAT_STEAL].data();
+   uint64_t* __restrict prev_busy = busy.data();
+   uint64_t* __restrict prev_total = total.data();
+   int32_t* __restrict busy_deltas = busy_delta.data();
+   int32_t* __restrict periods = period.data();
+   float* __restrict loads = load.data();
+
+   // Integer and float work are split so that each loop vectorizes
+   for (size_t i = 0; i < n; i++) {
+      uint64_t cpu_busy = user[i] + nice[i] + system[i] + irq[i] + softirq[i] + steal[i];
+      uint64_t cpu_total = cpu_busy + idle[i] + iowait[i];
+      busy_deltas[i] = jiffies_delta(cpu_busy, prev_busy[i]);
+      periods[i] = jiffies_delta(cpu_total, prev_total[i]);
+      prev_busy[i] = cpu_busy;
+      prev_total[i] = cpu_total;
+   }
+
+   for (size_t i = 0; i < n; i++) {
+      float previous = loads[i];
+      loads[i] = load_percent(busy_deltas[i], periods[i], previous);
+   }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef MANGOHUD_PROC_STAT_H
+#define MANGOHUD_PROC_STAT_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Column order of the cpu lines in /proc/stat
+enum proc_stat_field {
+   PROC_STAT_USER,
+   PROC_STAT_NICE,
+   PROC_STAT_SYSTEM,
+   PROC_STAT_IDLE,
+   PROC_STAT_IOWAIT,
+   PROC_STAT_IRQ,
+   PROC_STAT_SOFTIRQ,
+   PROC_STAT_STEAL,
+   PROC_STAT_GUEST,
+   PROC_STAT_GUEST_NICE,
+   PROC_STAT_FIELD_COUNT
+};
+
+// Raw cpu counters of /proc/stat, one column per field so that all cores'
+// values of a field are contiguous. Buffers are reused between parses.
+struct proc_stat_counters {
+   std::array<uint64_t, PROC_STAT_FIELD_COUNT> total {};
+   std::vector<int> cpu_id;
+   std::array<std::vector<uint64_t>, PROC_STAT_FIELD_COUNT> cpu;
+
+   size_t size() const { return cpu_id.size(); }
+   void resize(size_t n) {
+      cpu_id.resize(n);
+      for (auto& column : cpu)
+         column.resize(n);
+   }
+};
+
+// Load of the cpus between two consecutive /proc/stat samples. The per cpu
+// state is kept column-wise too, so update() is a straight loop over
+// contiguous arrays that the compiler vectorizes.
+struct proc_stat_load {
+   // busy and total jiffies at the previous update
+   std::vector<uint64_t> busy, total;
+   // jiffies elapsed since the previous update
+   std::vector<int32_t> busy_delta, period;
+   // percent, kept from the previous update when no time elapsed
+   std::vector<float> load;
+
+   uint64_t all_busy = 0, all_total = 0;
+   int32_t all_period = 0;
+   float all_load = 0.f;
+
+   void update(const proc_stat_counters& stat);
+};
+
+// Parses the "cpu" and "cpuN" lines at the start of /proc/stat. Missing
+// trailing fields of older kernels are read as 0. Returns false if the
+// aggregate "cpu" line is missing or malformed.
+bool parse_proc_stat(std::string_view contents, proc_stat_counters& out);
+
+// Parses the decimal number at p, stopping at end or the first non-digit.
+// Returns the position after the number, or p if there is none.
+const char* parse_proc_stat_u64(const char* p, const char* end, uint64_t& value);
+
+#endif //MANGOHUD_PROC_STAT_H
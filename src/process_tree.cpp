@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <unordered_set>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "process_tree.h"
+
+process_tree g_process_tree;
+
+// Parent pid and start time from /proc/<pid>/stat, the comm field may
+// contain spaces or ')'
+static bool read_ids(const char* pid, pid_t& ppid, uint64_t& starttime) {
+    auto stat = read_line(std::string("/proc/") + pid + "/stat");
+    auto end = stat.rfind(')');
+    if (end == std::string::npos || end + 4 > stat.size())
+        return false;
+
+    // ") S ppid", starttime is field 22 and ppid field 4
+    std::string_view fields(stat.c_str() + end + 4, stat.size() - end - 4);
+    int64_t parent;
+    if (!scan_i64(fields, parent))
+        return false;
+
+    int64_t skipped;
+    for (int i = 5; i < 22; i++)
+        if (!scan_i64(fields, skipped))
+            return false;
+    if (!scan_u64(fields, starttime))
+        return false;
+
+    ppid = parent;
+    return true;
+}
+
+void process_tree::update(pid_t root) {
+    if (root < 1)
+        root = getpid();
+
+    auto now = Clock::now();
+    if (root == m_root && now - m_last_refresh < refresh_interval)
+        return;
+
+    if (root != m_root)
+        m_members.clear();
+    m_root = root;
+    m_last_refresh = now;
+    refresh();
+}
+
+void process_tree::refresh() {
+    DIR* dirp = opendir("/proc");
+    if (!dirp) {
+        SPDLOG_ERROR("Error opening directory '/proc': {}", strerror(errno));
+        return;
+    }
+
+    // Members can be reparented out of the tree, their parents may have
+    // exited. Everything else keeps its cached parent while its inode is
+    // the same, a reused pid gets a new one.
+    std::unordered_set<pid_t> reread;
+    for (const auto& m : m_members) {
+        reread.insert(m.pid);
+        auto proc = m_procs.find(m.pid);
+        if (proc != m_procs.end())
+            reread.insert(proc->second.ppid);
+    }
+
+    m_generation++;
+    struct dirent* dp;
+    while ((dp = readdir(dirp))) {
+        char* end;
+        pid_t pid = strtol(dp->d_name, &end, 10);
+        if (*end || pid < 1)
+            continue;
+
+        auto it = m_procs.find(pid);
+        if (it != m_procs.end() && it->second.ino == dp->d_ino && !reread.count(pid)) {
+            it->second.generation = m_generation;
+            continue;
+        }
+
+        proc_stat_ids ids {dp->d_ino, 0, 0, m_generation};
+        if (!read_ids(dp->d_name, ids.ppid, ids.starttime)) {
+            if (it != m_procs.end())
+                m_procs.erase(it);
+            continue;
+        }
+        m_procs[pid] = ids;
+    }
+    closedir(dirp);
+
+    m_children.clear();
+    for (auto it = m_procs.begin(); it != m_procs.end();) {
+        if (it->second.generation != m_generation) {
+            it = m_procs.erase(it);
+            continue;
+        }
+        m_children.emplace(it->second.ppid, it->first);
+        ++it;
+    }
+
+    std::vector<pid_t> tree {m_root};
+    for (size_t i = 0; i < tree.size(); i++) {
+        auto range = m_children.equal_range(tree[i]);
+        for (auto it = range.first; it != range.second; ++it)
+            tree.push_back(it->second);
+    }
+
+    // keep the open files and io counters of members that are still the
+    // same process, a reused pid starts over with fresh files
+    std::vector<member> members;
+    members.reserve(tree.size());
+    for (auto pid : tree) {
+        auto proc = m_procs.find(pid);
+        // the root is kept even if its stat couldn't be read
+        uint64_t starttime = proc != m_procs.end() ? proc->second.starttime : 0;
+        auto it = std::find_if(m_members.begin(), m_members.end(),
+                               [&](const member& m) { return m.pid == pid && m.starttime == starttime; });
+        if (it != m_members.end()) {
+            members.push_back(std::move(*it));
+            continue;
+        }
+
+        auto path = "/proc/" + std::to_string(pid);
+        member m {pid, starttime, {}, {}, false, 0, 0};
+        m.statm.open(path + "/statm");
+        m.io.open(path + "/io");
+        members.push_back(std::move(m));
+    }
+    m_members = std::move(members);
+}
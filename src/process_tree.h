@@ -0,0 +1,66 @@
+#pragma once
+#ifndef MANGOHUD_PROCESS_TREE_H
+#define MANGOHUD_PROCESS_TREE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+#include "file_utils.h"
+#include "timing.hpp"
+
+// A root process and its descendants, e.g. the wine processes of a game
+// started through Proton. The member list is rebuilt at most every
+// refresh_interval from the parent of every pid in /proc. /proc/<pid>/stat
+// is only read for pids that are new, that now belong to another process
+// (a new inode for /proc/<pid>), and for the members and their parents, so
+// members that got reparented move out of the tree. Nothing is reparented
+// into it: an orphan goes to the nearest subreaper among its ancestors, so
+// one that lands on a member was already in the tree.
+//
+// Members are identified by pid and start time and keep their procfs files
+// open: if one exits and its pid gets reused before the next refresh, the
+// old fds read as empty instead of reporting the unrelated process, and the
+// new process gets its own member on the refresh after.
+class process_tree {
+public:
+    struct member {
+        pid_t pid;
+        uint64_t starttime;
+        persistent_file statm;
+        persistent_file io;
+        // last read /proc/<pid>/io counters, to sum deltas across exits
+        bool io_valid;
+        uint64_t read_bytes;
+        uint64_t write_bytes;
+    };
+
+    static constexpr Clock::duration refresh_interval = std::chrono::seconds(2);
+
+    // root < 1 is this process
+    void update(pid_t root);
+    std::vector<member>& members() { return m_members; }
+
+private:
+    void refresh();
+
+    pid_t m_root = 0;
+    Clock::time_point m_last_refresh {};
+    struct proc_stat_ids {
+        ino_t ino; // of /proc/<pid>, changes when the pid is reused
+        pid_t ppid;
+        uint64_t starttime;
+        uint32_t generation; // refresh that last saw the pid
+    };
+
+    // pid -> parent and start time, pids gone from /proc are dropped
+    std::unordered_map<pid_t, proc_stat_ids> m_procs;
+    uint32_t m_generation = 0;
+    std::unordered_multimap<pid_t, pid_t> m_children;
+    std::vector<member> m_members;
+};
+
+extern process_tree g_process_tree;
+
+#endif //MANGOHUD_PROCESS_TREE_H
@@ -0,0 +1,105 @@
+#pragma once
+#ifndef MANGOHUD_QUANTILE_SKETCH_H
+#define MANGOHUD_QUANTILE_SKETCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Histogram with logarithmically sized buckets for positive values.
+// Adding and removing a value is O(1), rank queries walk the buckets and
+// don't depend on how many values were added. Each bucket also keeps the
+// sum of its values so results are the mean of the matching bucket, which
+// is within `precision` of the exact order statistic.
+class quantile_sketch {
+public:
+  quantile_sketch(double min_value = 0.01, double max_value = 100000., double precision = 0.01)
+    : m_min(min_value),
+      m_log_base(std::log1p(precision))
+  {
+    size_t buckets = bucket_index(max_value) + 1;
+    m_counts.resize(buckets);
+    m_sums.resize(buckets);
+  }
+
+  void add(double value) {
+    auto i = bucket_index(value);
+    m_counts[i]++;
+    m_sums[i] += value;
+    m_count++;
+    m_sum += value;
+  }
+
+  void remove(double value) {
+    auto i = bucket_index(value);
+    if (m_counts[i] == 0)
+      return;
+    m_counts[i]--;
+    m_sums[i] = m_counts[i] ? m_sums[i] - value : 0.;
+    m_count--;
+    m_sum = m_count ? m_sum - value : 0.;
+  }
+
+  void clear() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    std::fill(m_sums.begin(), m_sums.end(), 0.);
+    m_count = 0;
+    m_sum = 0.;
+  }
+
+  uint64_t count() const { return m_count; }
+  double sum() const { return m_sum; }
+  double mean() const { return m_count ? m_sum / m_count : 0.; }
+
+  // value at `rank` (0-based) when sorted in descending order
+  double at_rank_desc(uint64_t rank) const {
+    if (rank >= m_count)
+      return 0.;
+
+    if (rank < m_count / 2) {
+      uint64_t seen = 0;
+      for (size_t i = m_counts.size(); i-- > 0;) {
+        seen += m_counts[i];
+        if (seen > rank)
+          return m_sums[i] / m_counts[i];
+      }
+    } else {
+      uint64_t asc_rank = m_count - 1 - rank;
+      uint64_t seen = 0;
+      for (size_t i = 0; i < m_counts.size(); i++) {
+        seen += m_counts[i];
+        if (seen > asc_rank)
+          return m_sums[i] / m_counts[i];
+      }
+    }
+    return 0.;
+  }
+
+  // value below which `q` (0..1) of the values fall
+  double quantile(double q) const {
+    if (m_count == 0)
+      return 0.;
+    uint64_t rank = std::min<uint64_t>(q * m_count, m_count - 1);
+    return at_rank_desc(m_count - 1 - rank);
+  }
+
+  double max() const { return at_rank_desc(0); }
+
+private:
+  size_t bucket_index(double value) const {
+    if (!(value > m_min))
+      return 0;
+    size_t i = std::log(value / m_min) / m_log_base;
+    return m_counts.empty() ? i : std::min(i, m_counts.size() - 1);
+  }
+
+  double m_min;
+  double m_log_base;
+  std::vector<uint32_t> m_counts;
+  std::vector<double> m_sums;
+  uint64_t m_count = 0;
+  double m_sum = 0.;
+};
+
+#endif //MANGOHUD_QUANTILE_SKETCH_H
@@ -0,0 +1,138 @@
+#pragma once
+#ifndef MANGOHUD_ROLLING_WINDOW_H
+#define MANGOHUD_ROLLING_WINDOW_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mean, max and percentiles over the last `span` samples of a series.
+// Everything is updated incrementally as a sample enters and the oldest
+// one leaves: a running sum for the mean, a monotonic queue for the max
+// and a fixed histogram over [0, range] for the percentiles. push() is
+// O(1) amortized and no query depends on the length of the window.
+// Samples can also carry a time, expire() then bounds the window by
+// duration as well, `span` is only the most it holds.
+class rolling_window {
+public:
+  static constexpr size_t histogram_bins = 512;
+
+  explicit rolling_window(size_t span = 1, float range = 100.f) { reset(span, range); }
+
+  void reset(size_t span, float range) {
+    span = std::max<size_t>(span, 1);
+    m_values.assign(span, 0.f);
+    m_times.assign(span, 0);
+    m_max_queue.assign(span, 0);
+    m_histogram.fill(0);
+    m_bin_scale = range > 0.f ? histogram_bins / range : 0.f;
+    m_bin_width = range > 0.f ? range / histogram_bins : 0.f;
+    m_next = m_count = 0;
+    m_max_head = m_max_size = 0;
+    m_pushed = 0;
+    m_sum = 0.;
+  }
+
+  void push(float value, uint64_t time = 0) {
+    const size_t span = m_values.size();
+
+    if (m_count == span)
+      pop_front();
+    m_count++;
+
+    m_values[m_next] = value;
+    m_times[m_next] = time;
+    m_sum += value;
+    m_histogram[bin(value)]++;
+
+    while (m_max_size && value_at(m_max_queue[(m_max_head + m_max_size - 1) % span]) <= value)
+      m_max_size--;
+    m_max_queue[(m_max_head + m_max_size) % span] = m_pushed;
+    m_max_size++;
+
+    m_pushed++;
+    m_next = (m_next + 1) % span;
+    // Re-add from scratch once per lap so float error can't build up
+    if (m_next == 0) {
+      m_sum = 0.;
+      for (size_t i = span - m_count; i < span; i++)
+        m_sum += m_values[i];
+    }
+  }
+
+  // Drops the samples pushed with a time at or before `now - duration`,
+  // but keeps the newest one so a sparse series still has a value
+  void expire(uint64_t now, uint64_t duration) {
+    while (m_count > 1 && m_times[front()] + duration <= now)
+      pop_front();
+  }
+
+  size_t size() const { return m_count; }
+  bool empty() const { return m_count == 0; }
+
+  float last() const {
+    return m_count ? m_values[(m_next + m_values.size() - 1) % m_values.size()] : 0.f;
+  }
+
+  float mean() const { return m_count ? float(m_sum / m_count) : 0.f; }
+
+  float max() const { return m_max_size ? value_at(m_max_queue[m_max_head]) : 0.f; }
+
+  // Upper edge of the histogram bin holding the p-th quantile (0 < p <= 1),
+  // capped at the real window max so it never reports more than was seen.
+  float percentile(float p) const {
+    if (!m_count)
+      return 0.f;
+    size_t above = m_count - std::min(m_count, size_t(p * m_count + 0.5f));
+    size_t seen = 0;
+    for (size_t i = histogram_bins; i-- > 0;) {
+      seen += m_histogram[i];
+      if (seen > above)
+        return std::min((i + 1) * m_bin_width, max());
+    }
+    return 0.f;
+  }
+
+private:
+  size_t front() const { return (m_next + m_values.size() - m_count) % m_values.size(); }
+
+  void pop_front() {
+    size_t i = front();
+    m_sum -= m_values[i];
+    m_histogram[bin(m_values[i])]--;
+    // The queue front may be the sample leaving
+    if (m_max_size && m_max_queue[m_max_head] == m_pushed - m_count) {
+      m_max_head = (m_max_head + 1) % m_values.size();
+      m_max_size--;
+    }
+    m_count--;
+  }
+
+  size_t bin(float value) const {
+    if (value <= 0.f)
+      return 0;
+    return std::min(size_t(value * m_bin_scale), histogram_bins - 1);
+  }
+
+  float value_at(uint64_t index) const { return m_values[index % m_values.size()]; }
+
+  std::vector<float> m_values;
+  std::vector<uint64_t> m_times;
+  size_t m_next = 0;
+  size_t m_count = 0;
+  uint64_t m_pushed = 0;
+  double m_sum = 0.;
+
+  // Sample indices with decreasing values, front is the window max
+  std::vector<uint64_t> m_max_queue;
+  size_t m_max_head = 0;
+  size_t m_max_size = 0;
+
+  std::array<uint16_t, histogram_bins> m_histogram {};
+  float m_bin_scale = 0.f;
+  float m_bin_width = 0.f;
+};
+
+#endif //MANGOHUD_ROLLING_WINDOW_H
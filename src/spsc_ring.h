@@ -0,0 +1,59 @@
+#pragma once
+#ifndef MANGOHUD_SPSC_RING_H
+#define MANGOHUD_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// push() never blocks, it fails when the ring is full.
+template<typename T>
+class spsc_ring {
+public:
+  // capacity is rounded up to a power of two
+  explicit spsc_ring(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    m_buffer.resize(size);
+    m_mask = size - 1;
+  }
+
+  bool push(const T& value) {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+      return false;
+
+    m_buffer[tail & m_mask] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& value) {
+    auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+      return false;
+
+    value = m_buffer[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return m_mask + 1; }
+
+  // Only safe while neither side is running
+  void clear() { m_head.store(m_tail.load()); }
+
+private:
+  std::vector<T> m_buffer;
+  size_t m_mask;
+  alignas(64) std::atomic<size_t> m_head {0};
+  alignas(64) std::atomic<size_t> m_tail {0};
+};
+
+#endif //MANGOHUD_SPSC_RING_H
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <spdlog/spdlog.h>
+
+#include "thread_stats.h"
+#include "file_utils.h"
+
+ThreadStats g_thread_stats;
+
+// struct linux_dirent64 from getdents64(2), glibc only declares it with _GNU_SOURCE
+struct task_dirent {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+ThreadStats::~ThreadStats() {
+    close_all();
+}
+
+void ThreadStats::close_all() {
+    for (auto& entry : m_threads)
+        close(entry.fd);
+    m_threads.clear();
+    if (m_task_fd >= 0)
+        close(m_task_fd);
+    m_task_fd = -1;
+}
+
+bool ThreadStats::open_task_dir(pid_t pid) {
+    close_all();
+    m_pid = pid;
+    m_last_rescan = {};
+    m_last_update = {};
+
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    m_task_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_task_fd < 0) {
+        SPDLOG_ERROR("can't open {}: {}", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int ThreadStats::open_stat(pid_t tid) {
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", tid);
+    return openat(m_task_fd, path, O_RDONLY | O_CLOEXEC);
+}
+
+// Adds the threads that appeared since the last rescan and drops the ones that exited
+void ThreadStats::rescan() {
+    m_generation++;
+    lseek(m_task_fd, 0, SEEK_SET);
+
+    long n;
+    while ((n = syscall(SYS_getdents64, m_task_fd, m_dents.data(), m_dents.size())) > 0) {
+        for (long pos = 0; pos < n;) {
+            auto dent = reinterpret_cast<task_dirent*>(m_dents.data() + pos);
+            pos += dent->d_reclen;
+
+            char* end;
+            pid_t tid = strtol(dent->d_name, &end, 10);
+            if (*end || tid < 1)
+                continue;
+
+            auto it = std::lower_bound(m_threads.begin(), m_threads.end(), tid,
+                                       [](const thread_entry& e, pid_t t) { return e.tid < t; });
+            if (it != m_threads.end() && it->tid == tid) {
+                // Still listed although its fd stopped reading: the thread
+                // exited and a new one got its tid, which needs its own fd
+                if (it->dead) {
+                    close(it->fd);
+                    it->fd = open_stat(tid);
+                    it->valid = false;
+                    it->dead = false;
+                    if (it->fd < 0)
+                        continue;
+                }
+                it->generation = m_generation;
+                continue;
+            }
+
+            int fd = open_stat(tid);
+            if (fd < 0)
+                continue;
+            thread_entry entry {tid, fd, m_generation, false, false, 0, {tid, {}, 0.f}};
+            m_threads.insert(it, entry);
+        }
+    }
+    if (n < 0)
+        SPDLOG_DEBUG("getdents64 of /proc/{}/task failed: {}", m_pid, strerror(errno));
+
+    auto gone = std::remove_if(m_threads.begin(), m_threads.end(), [this](const thread_entry& e) {
+        if (e.generation == m_generation)
+            return false;
+        if (e.fd >= 0)
+            close(e.fd);
+        return true;
+    });
+    m_threads.erase(gone, m_threads.end());
+}
+
+bool ThreadStats::read_thread(thread_entry& entry, float elapsed_s) {
+    static const long clock_ticks = [] {
+        auto ticks = sysconf(_SC_CLK_TCK);
+        return ticks > 0 ? ticks : 100;
+    }();
+
+    ssize_t n = pread(entry.fd, m_stat.data(), m_stat.size(), 0);
+    if (n <= 0)
+        return false;
+
+    // "tid (comm) S ppid ...", comm may contain spaces and ')'
+    std::string_view stat(m_stat.data(), n);
+    auto open = stat.find('(');
+    auto close = stat.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open)
+        return false;
+
+    auto comm = stat.substr(open + 1, std::min<size_t>(close - open - 1, sizeof(entry.load.name) - 1));
+    memcpy(entry.load.name, comm.data(), comm.size());
+    entry.load.name[comm.size()] = '\0';
+
+    // skip the state, then ppid to cmajflt come before utime and stime
+    auto fields = stat.substr(std::min(close + 4, stat.size()));
+    int64_t value = 0;
+    for (int i = 0; i < 10; i++)
+        if (!scan_i64(fields, value))
+            return false;
+
+    uint64_t utime, stime;
+    if (!scan_u64(fields, utime) || !scan_u64(fields, stime))
+        return false;
+
+    uint64_t ticks = utime + stime;
+    entry.load.load = entry.valid && elapsed_s > 0.f
+        ? std::min(100.f, (ticks - entry.ticks) * 100.f / clock_ticks / elapsed_s) : 0.f;
+    entry.ticks = ticks;
+    entry.valid = true;
+    return true;
+}
+
+void ThreadStats::update(pid_t pid, size_t top_count) {
+    if (pid < 1)
+        pid = getpid();
+    if ((pid != m_pid || m_task_fd < 0) && !open_task_dir(pid))
+        return;
+
+    auto now = Clock::now();
+    if (now - m_last_rescan >= rescan_interval) {
+        m_last_rescan = now;
+        rescan();
+    }
+
+    float elapsed_s = m_last_update.time_since_epoch().count()
+        ? std::chrono::duration<float>(now - m_last_update).count() : 0.f;
+    m_last_update = now;
+
+    m_order.clear();
+    for (auto& entry : m_threads) {
+        if (!read_thread(entry, elapsed_s)) {
+            // exited, dropped or reopened on the next rescan
+            entry.valid = false;
+            entry.dead = true;
+            continue;
+        }
+        m_order.push_back(&entry);
+        if (entry.tid == pid)
+            m_main_load = entry.load.load;
+    }
+
+    top_count = std::min({top_count, max_top, m_order.size()});
+    std::partial_sort(m_order.begin(), m_order.begin() + top_count, m_order.end(),
+                      [](const thread_entry* a, const thread_entry* b) { return a->load.load > b->load.load; });
+
+    for (size_t i = 0; i < top_count; i++)
+        m_top[i] = m_order[i]->load;
+    m_top_count = top_count;
+}
+
+size_t ThreadStats::top(std::array<thread_load, max_top>& out) const {
+    std::copy_n(m_top.begin(), m_top_count, out.begin());
+    return m_top_count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef MANGOHUD_THREAD_STATS_H
+#define MANGOHUD_THREAD_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+
+#include "timing.hpp"
+
+struct thread_load {
+    pid_t tid;
+    char name[16];
+    // percent of one core
+    float load;
+};
+
+// CPU time of each thread of the hooked process (or the gamescope app),
+// from /proc/<pid>/task/<tid>/stat. The task directory is listed with
+// getdents64 at most every rescan_interval, and each thread's stat file
+// stays open, so a poll with an unchanged thread set only does one pread
+// per thread and doesn't allocate.
+class ThreadStats {
+public:
+    static constexpr size_t max_top = 16;
+    static constexpr Clock::duration rescan_interval = std::chrono::seconds(1);
+
+    ThreadStats() = default;
+    ~ThreadStats();
+    ThreadStats(const ThreadStats&) = delete;
+    ThreadStats& operator=(const ThreadStats&) = delete;
+
+    // pid < 1 is this process
+    void update(pid_t pid, size_t top_count);
+    // Copies the busiest threads, busiest first, and returns their count.
+    // Called by the hw info thread like update(), the HUD gets them from
+    // the hw snapshot.
+    size_t top(std::array<thread_load, max_top>& out) const;
+    float main_thread_load() const { return m_main_load; }
+
+private:
+    struct thread_entry {
+        pid_t tid;
+        int fd;
+        uint32_t generation;
+        bool valid;
+        // a read failed since the last rescan, the tid is gone or was reused
+        bool dead;
+        uint64_t ticks;
+        thread_load load;
+    };
+
+    bool open_task_dir(pid_t pid);
+    int open_stat(pid_t tid);
+    void rescan();
+    bool read_thread(thread_entry& entry, float elapsed_s);
+    void close_all();
+
+    pid_t m_pid = 0;
+    int m_task_fd = -1;
+    uint32_t m_generation = 0;
+    Clock::time_point m_last_rescan {};
+    Clock::time_point m_last_update {};
+
+    // sorted by tid
+    std::vector<thread_entry> m_threads;
+    std::vector<thread_entry*> m_order;
+    alignas(8) std::array<char, 8192> m_dents;
+    std::array<char, 1024> m_stat;
+
+    std::array<thread_load, max_top> m_top;
+    size_t m_top_count = 0;
+    std::atomic<float> m_main_load {0.f};
+};
+
+extern ThreadStats g_thread_stats;
+
+#endif //MANGOHUD_THREAD_STATS_H
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef MANGOHUD_TIMER_WHEEL_H
+#define MANGOHUD_TIMER_WHEEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Hashed timer wheel for periodic tasks. Each task has a period in ticks
+// and a rough cost; new tasks are placed in the least loaded slot within
+// their first period so expensive tasks don't all land on the same tick.
+// Tasks that share a slot run in the order they were added. Slots with
+// nothing to run can be skipped, see idle_ticks().
+class timer_wheel {
+public:
+  struct task {
+    std::string name;
+    uint32_t period;               // in ticks
+    uint32_t cost;                 // relative, only used for placement
+    std::function<bool()> needed;  // skipped (but kept scheduled) when false
+    std::function<void()> run;
+  };
+
+  explicit timer_wheel(size_t slots = 64)
+    : m_slots(slots), m_slot_cost(slots) {}
+
+  void add(task t) {
+    t.period = std::max<uint32_t>(t.period, 1);
+    size_t best = m_current;
+    for (uint32_t i = 0; i < std::min<size_t>(t.period, m_slots.size()); i++) {
+      size_t slot = (m_current + i) % m_slots.size();
+      if (m_slot_cost[slot] < m_slot_cost[best])
+        best = slot;
+    }
+
+    size_t index = m_tasks.size();
+    uint64_t due = m_now + (best + m_slots.size() - m_current) % m_slots.size();
+    // cost is spread over every slot the task will visit
+    for (size_t slot = best % t.period; slot < m_slots.size(); slot += t.period)
+      m_slot_cost[slot] += t.cost;
+    m_tasks.push_back({std::move(t), due});
+    insert(best, index);
+  }
+
+  // Runs the tasks due on the current tick and advances the wheel
+  void tick() {
+    // The slot gets the scratch list's storage back, so rescheduling
+    // doesn't allocate once the lists have grown to size
+    m_scratch.swap(m_slots[m_current]);
+
+    for (auto index : m_scratch) {
+      auto& entry = m_tasks[index];
+      // Periods longer than the wheel come around more than once
+      if (entry.due > m_now) {
+        insert(m_current, index);
+        continue;
+      }
+
+      if (!entry.t.needed || entry.t.needed())
+        entry.t.run();
+
+      entry.due = m_now + entry.t.period;
+      insert((m_current + entry.t.period) % m_slots.size(), index);
+    }
+
+    m_scratch.clear();
+    skip(1);
+  }
+
+  // Number of ticks from the current one on with no due and needed task,
+  // at most one turn of the wheel. The caller can skip() them and sleep
+  // until the tick after instead of waking up for nothing.
+  size_t idle_ticks() const {
+    size_t idle = 0;
+    for (; idle < m_slots.size(); idle++) {
+      uint64_t now = m_now + idle;
+      for (auto index : m_slots[(m_current + idle) % m_slots.size()]) {
+        auto& entry = m_tasks[index];
+        if (entry.due <= now && (!entry.t.needed || entry.t.needed()))
+          return idle;
+      }
+    }
+    return idle;
+  }
+
+  // Advances the wheel without running anything. Tasks in the skipped
+  // slots that weren't needed run on their slot's next turn.
+  void skip(size_t ticks) {
+    m_current = (m_current + ticks) % m_slots.size();
+    m_now += ticks;
+  }
+
+  void clear() {
+    for (auto& slot : m_slots)
+      slot.clear();
+    std::fill(m_slot_cost.begin(), m_slot_cost.end(), 0);
+    m_tasks.clear();
+    m_current = 0;
+    m_now = 0;
+  }
+
+  bool empty() const { return m_tasks.empty(); }
+
+private:
+  struct entry {
+    task t;
+    uint64_t due;  // tick the task runs next
+  };
+
+  void insert(size_t slot, size_t index) {
+    auto& list = m_slots[slot];
+    list.insert(std::upper_bound(list.begin(), list.end(), index), index);
+  }
+
+  std::vector<std::vector<size_t>> m_slots;
+  std::vector<uint32_t> m_slot_cost;
+  std::vector<entry> m_tasks;
+  std::vector<size_t> m_scratch;
+  size_t m_current = 0;
+  uint64_t m_now = 0;
+};
+
+#endif //MANGOHUD_TIMER_WHEEL_H
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef MANGOHUD_TRIPLE_BUFFER_H
+#define MANGOHUD_TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Latest-value handoff between exactly one writer and one reader thread.
+// The writer fills back() and publishes it with one atomic exchange; the
+// reader picks up the newest published buffer in read(). Neither side
+// blocks or copies, and the buffer returned by read() isn't touched by
+// the writer until the reader calls read() again.
+template<typename T>
+class triple_buffer {
+public:
+  // Writer side. back() holds whatever was published two rounds ago, so
+  // it has to be filled completely before publish().
+  T& back() { return m_buffers[m_back]; }
+
+  void publish() {
+    m_back = m_middle.exchange(m_back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+  }
+
+  // Reader side
+  const T& read() {
+    if (m_middle.load(std::memory_order_relaxed) & fresh_bit)
+      m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+    return m_buffers[m_front];
+  }
+
+private:
+  static constexpr uint8_t index_mask = 3;
+  static constexpr uint8_t fresh_bit = 4;
+
+  std::array<T, 3> m_buffers {};
+  alignas(64) uint8_t m_back = 0;
+  alignas(64) std::atomic<uint8_t> m_middle {1};
+  alignas(64) uint8_t m_front = 2;
+};
+
+#endif //MANGOHUD_TRIPLE_BUFFER_H
@@ -64,6 +64,7 @@
 #endif
 #include "imgui_utils.h"
 #include "fps_limiter.h"
+#include "overhead.h"
 
 using namespace std;
 
@@ -1549,6 +1550,9 @@ static struct overlay_draw *before_present(struct swapchain_data *swapchain_data
 
    if (swapchain_data->sw_stats.n_frames > 0) {
       compute_swapchain_display(swapchain_data);
+
+      static const size_t draw_stage = g_overhead.stage("vk_draw");
+      ScopedOverhead timer(draw_stage);
       draw = render_swapchain_display(swapchain_data, present_queue,
                                       wait_semaphores, n_wait_semaphores,
                                       imageIndex);
@@ -0,0 +1,155 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+extern "C" {
+#include <cmocka.h>
+}
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "../src/proc_stat.h"
+
+#define UNUSED(x) (void)(x)
+
+static std::string read_fixture(const char* path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Every fixture's aggregate line is the sum of its cpu lines
+static void check_fixture(const char* path, size_t cpus) {
+    std::string contents = read_fixture(path);
+    assert_false(contents.empty());
+
+    proc_stat_counters stat;
+    assert_true(parse_proc_stat(contents, stat));
+    assert_int_equal(stat.size(), cpus);
+
+    for (size_t f = 0; f < PROC_STAT_FIELD_COUNT; f++) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < stat.size(); i++)
+            sum += stat.cpu[f][i];
+        assert_int_equal(sum, stat.total[f]);
+    }
+}
+
+static void test_proc_stat_fixtures(void **state) {
+    UNUSED(state);
+    check_fixture("./proc_stat_8", 8);
+    check_fixture("./proc_stat_64", 64);
+    check_fixture("./proc_stat_256", 256);
+}
+
+static void test_proc_stat_cpu_ids(void **state) {
+    UNUSED(state);
+    // cpu13 is offline in this one
+    std::string contents = read_fixture("./proc_stat_64");
+    proc_stat_counters stat;
+    assert_true(parse_proc_stat(contents, stat));
+    assert_int_equal(stat.cpu_id[12], 12);
+    assert_int_equal(stat.cpu_id[13], 14);
+    assert_int_equal(stat.cpu_id[63], 64);
+    assert_int_equal(stat.cpu[PROC_STAT_USER][0], 64008880);
+    assert_int_equal(stat.cpu[PROC_STAT_IDLE][1], 3001710946);
+}
+
+static void test_proc_stat_short_lines(void **state) {
+    UNUSED(state);
+    // Older kernels don't have steal, guest and guest_nice
+    proc_stat_counters stat;
+    assert_true(parse_proc_stat("cpu  10 20 30 40 50 60 70\ncpu0 10 20 30 40 50 60 70\nintr 1\n", stat));
+    assert_int_equal(stat.size(), 1);
+    assert_int_equal(stat.total[PROC_STAT_SOFTIRQ], 70);
+    assert_int_equal(stat.cpu[PROC_STAT_STEAL][0], 0);
+    assert_int_equal(stat.cpu[PROC_STAT_GUEST_NICE][0], 0);
+
+    // Parsing fewer cpus than last time shrinks the columns
+    assert_true(parse_proc_stat("cpu  1 2 3 4 5 6 7 8 9 10\n", stat));
+    assert_int_equal(stat.size(), 0);
+
+    assert_false(parse_proc_stat("", stat));
+    assert_false(parse_proc_stat("intr 1\n", stat));
+}
+
+static void test_proc_stat_u64(void **state) {
+    UNUSED(state);
+    const char* inputs[] = {"0 ", "7", "12345678", "123456789 ", "18446744073709551615\n"};
+    const uint64_t expected[] = {0, 7, 12345678, 123456789, UINT64_MAX};
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        std::string input = inputs[i];
+        uint64_t value = 1;
+        const char* end = parse_proc_stat_u64(input.data(), input.data() + input.size(), value);
+        assert_int_equal(value, expected[i]);
+        assert_true(end == input.data() + input.find_first_not_of("0123456789") ||
+                    (end == input.data() + input.size() && input.find_first_not_of("0123456789") == std::string::npos));
+    }
+
+    // no digits leaves value alone
+    std::string blank = " 1";
+    uint64_t value = 42;
+    assert_true(parse_proc_stat_u64(blank.data(), blank.data() + blank.size(), value) == blank.data());
+    assert_int_equal(value, 42);
+}
+
+// The getline + sscanf loop this parser replaced, for comparison
+static size_t parse_sscanf(const std::string& contents) {
+    std::istringstream file(contents);
+    std::string line;
+    size_t cpus = 0;
+    unsigned long long v[10];
+    while (std::getline(file, line) && line.compare(0, 3, "cpu") == 0) {
+        int id;
+        if (sscanf(line.c_str(), "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &id, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9]) == 11)
+            cpus++;
+    }
+    return cpus;
+}
+
+// Prints timings only, the numbers depend on the machine
+static void test_proc_stat_benchmark(void **state) {
+    UNUSED(state);
+    using clock = std::chrono::steady_clock;
+    const int rounds = 2000;
+
+    for (const char* path : {"./proc_stat_8", "./proc_stat_64", "./proc_stat_256"}) {
+        std::string contents = read_fixture(path);
+        proc_stat_counters stat;
+        size_t cpus = 0;
+
+        auto start = clock::now();
+        for (int i = 0; i < rounds; i++) {
+            parse_proc_stat(contents, stat);
+            cpus += stat.size();
+        }
+        auto parser = clock::now() - start;
+
+        start = clock::now();
+        for (int i = 0; i < rounds; i++)
+            cpus += parse_sscanf(contents);
+        auto sscanf = clock::now() - start;
+
+        assert_true(cpus > 0);
+        printf("%-16s parse_proc_stat %8.0f ns, getline+sscanf %8.0f ns\n", path,
+               std::chrono::duration<double, std::nano>(parser).count() / rounds,
+               std::chrono::duration<double, std::nano>(sscanf).count() / rounds);
+    }
+}
+
+const struct CMUnitTest proc_stat_tests[] = {
+    cmocka_unit_test(test_proc_stat_fixtures),
+    cmocka_unit_test(test_proc_stat_cpu_ids),
+    cmocka_unit_test(test_proc_stat_short_lines),
+    cmocka_unit_test(test_proc_stat_u64),
+    cmocka_unit_test(test_proc_stat_benchmark)
+};
+
+int main(void) {
+    return cmocka_run_group_tests(proc_stat_tests, NULL, NULL);
+}